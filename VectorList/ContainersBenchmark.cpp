@@ -0,0 +1,787 @@
+
+#include "pch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "catch.hpp"
+
+#include "MyConcurrentQueue.h"
+#include "MyDeque.h"
+#include "MyList.h"
+#include "MyRope.h"
+#include "MySkipList.h"
+#include "MyString.h"
+
+// The benchmarks are hidden from the default run, start them with the [benchmark] tag.
+// They allocate through std::allocator to keep the memory spy output readable.
+
+typedef std::chrono::steady_clock BenchClock;
+
+static uint64_t	nowNs()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		BenchClock::now().time_since_epoch()).count());
+}
+
+static void	printLatencies(const char* name, std::vector<uint64_t>& latencies, const double seconds)
+{
+	std::sort(latencies.begin(), latencies.end());
+
+	const size_t count = latencies.size();
+
+	std::printf("%-28s %12.0f ops/s   p50 %8llu ns   p99 %8llu ns   p99.9 %8llu ns\n", name, count / seconds,
+		latencies[count / 2], latencies[count * 99 / 100], latencies[count * 999 / 1000]);
+}
+
+// Run producerCount threads pushing timestamps while one consumer pops them
+template <typename Push, typename Pop>
+static void	runProducerConsumer(const char* name, const int producerCount, const size_t itemsPerProducer,
+	Push push, Pop pop)
+{
+	const size_t			total = producerCount * itemsPerProducer;
+	std::vector<uint64_t>	latencies;
+	std::vector<std::thread>	producers;
+
+	latencies.reserve(total);
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int p = 0; p < producerCount; p++)
+	{
+		producers.emplace_back([&push, itemsPerProducer]()
+		{
+			for (size_t i = 0; i < itemsPerProducer; i++)
+				while (!push(nowNs()))
+					std::this_thread::yield();
+		});
+	}
+
+	uint64_t timestamp;
+
+	while (latencies.size() < total)
+	{
+		if (pop(timestamp))
+			latencies.push_back(nowNs() - timestamp);
+	}
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	for (std::thread& producer : producers)
+		producer.join();
+
+	printLatencies(name, latencies, seconds);
+}
+
+TEST_CASE("Benchmark_Queues", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_Queues================\n");
+
+	const size_t	itemsPerProducer = 200000;
+	const size_t	capacity = 4096;
+
+	for (int producerCount = 1; producerCount <= 4; producerCount *= 2)
+	{
+		std::printf("\n%d producer(s), 1 consumer\n", producerCount);
+
+		{
+			typedef my::list<uint64_t, std::allocator<uint64_t>> TimestampList;
+
+			std::mutex				mutex;
+			TimestampList			shared;
+			TimestampList			consumed;
+			TimestampList::iterator	next = consumed.end();
+
+			// my::list can't pop its front, the consumer takes the whole list at once instead
+			runProducerConsumer("mutex + my::list", producerCount, itemsPerProducer,
+				[&](uint64_t item)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					shared.push_back(item);
+					return true;
+				},
+				[&](uint64_t& item)
+				{
+					if (next == consumed.end())
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+
+						consumed = std::move(shared);
+						next = consumed.begin();
+
+						if (next == consumed.end())
+							return false;
+					}
+
+					item = *next++;
+					return true;
+				});
+		}
+
+		{
+			my::mpsc_queue<uint64_t, std::allocator<uint64_t>> queue(capacity);
+
+			runProducerConsumer("my::mpsc_queue", producerCount, itemsPerProducer,
+				[&](uint64_t item) { return queue.push(item); },
+				[&](uint64_t& item) { return queue.pop(item); });
+		}
+
+		{
+			my::mpmc_queue<uint64_t, std::allocator<uint64_t>> queue(capacity);
+
+			runProducerConsumer("my::mpmc_queue", producerCount, itemsPerProducer,
+				[&](uint64_t item) { return queue.push(item); },
+				[&](uint64_t& item) { return queue.pop(item); });
+		}
+	}
+}
+
+// Best effort, the thread keeps running wherever the OS puts it if the core doesn't exist
+static void	pinThread(std::thread& thread, const unsigned core)
+{
+	const unsigned coreCount = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef _WIN32
+	SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << (core % coreCount));
+#else
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core % coreCount, &cpus);
+
+	pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+// Hand itemCount timestamps from a producer pinned to core 0 to a consumer pinned to core 1, batchSize at a time
+template <typename Push, typename Pop>
+static void	runPinnedPair(const char* name, const size_t itemCount, const size_t batchSize, Push push, Pop pop)
+{
+	std::vector<uint64_t> latencies;
+	latencies.reserve(itemCount);
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	std::thread producer([&push, itemCount, batchSize]()
+	{
+		std::vector<uint64_t> batch(batchSize);
+
+		for (size_t sent = 0; sent < itemCount;)
+		{
+			const size_t count = std::min(batchSize, itemCount - sent);
+			size_t pushed = 0;
+
+			for (size_t i = 0; i < count; i++)
+				batch[i] = nowNs();
+
+			while (pushed < count)
+				pushed += push(&batch[pushed], count - pushed);
+
+			sent += count;
+		}
+	});
+
+	std::thread consumer([&pop, &latencies, itemCount, batchSize]()
+	{
+		std::vector<uint64_t> batch(batchSize);
+
+		while (latencies.size() < itemCount)
+		{
+			const size_t count = pop(&batch[0], batchSize);
+			const uint64_t now = nowNs();
+
+			for (size_t i = 0; i < count; i++)
+				latencies.push_back(now - batch[i]);
+		}
+	});
+
+	pinThread(producer, 0);
+	pinThread(consumer, 1);
+
+	producer.join();
+	consumer.join();
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	printLatencies(name, latencies, seconds);
+}
+
+TEST_CASE("Benchmark_SpscQueue", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_SpscQueue================\n");
+
+	const size_t	itemCount = 2000000;
+	const size_t	capacity = 4096;
+
+	for (size_t batchSize = 1; batchSize <= 32; batchSize *= 32)
+	{
+		std::printf("\nBatches of %llu\n", static_cast<unsigned long long>(batchSize));
+
+		{
+			std::mutex								mutex;
+			my::deque<uint64_t, std::allocator<uint64_t>>	queue;
+
+			runPinnedPair("mutex + my::deque", itemCount, batchSize,
+				[&](const uint64_t* items, size_t count)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					count = std::min(count, capacity - queue.size());
+
+					for (size_t i = 0; i < count; i++)
+						queue.push_back(items[i]);
+
+					return count;
+				},
+				[&](uint64_t* items, size_t count)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					count = std::min(count, queue.size());
+
+					for (size_t i = 0; i < count; i++)
+					{
+						items[i] = queue.front();
+						queue.pop_front();
+					}
+
+					return count;
+				});
+		}
+
+		{
+			my::spsc_queue<uint64_t, std::allocator<uint64_t>> queue(capacity);
+
+			runPinnedPair("my::spsc_queue", itemCount, batchSize,
+				[&](const uint64_t* items, size_t count) { return queue.push(items, count); },
+				[&](uint64_t* items, size_t count) { return queue.pop(items, count); });
+		}
+	}
+}
+
+// Run readerCount threads doing lookupsPerReader lookups while the calling thread inserts
+template <typename Lookup, typename Insert>
+static void	runLookups(const char* name, const int readerCount, const int lookupsPerReader, const int maxInserts,
+	Lookup lookup, Insert insert)
+{
+	std::atomic<bool>			reading(true);
+	std::atomic<size_t>			found(0);
+	std::vector<std::thread>	readers;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int r = 0; r < readerCount; r++)
+	{
+		readers.emplace_back([&lookup, &found, lookupsPerReader, r]()
+		{
+			uint32_t	seed = 0x12345u + r;
+			size_t		hits = 0;
+
+			for (int i = 0; i < lookupsPerReader; i++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+
+				if (lookup(static_cast<int>(seed >> 8)))
+					hits++;
+			}
+
+			found += hits;
+		});
+	}
+
+	int inserted = 0;
+
+	// Keep writing until every reader is done
+	std::thread writer([&insert, &reading, &inserted, maxInserts]()
+	{
+		while (reading.load() && inserted < maxInserts)
+			insert(inserted++ * 2 + 1);
+	});
+
+	for (std::thread& reader : readers)
+		reader.join();
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	reading = false;
+	writer.join();
+
+	std::printf("%-28s %d reader(s) %12.0f lookups/s   %d concurrent inserts\n", name, readerCount,
+		readerCount * lookupsPerReader / seconds, inserted);
+}
+
+TEST_CASE("Benchmark_SkipList", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_SkipList================\n");
+
+	const int	itemCount = 1 << 20;
+	const int	lookupsPerReader = 1000000;
+
+	for (int readerCount = 1; readerCount <= 4; readerCount *= 2)
+	{
+		{
+			std::mutex		mutex;
+			std::set<int>	set;
+
+			for (int i = 0; i < itemCount; i++)
+				set.insert(i * 2);
+
+			runLookups("mutex + std::set", readerCount, lookupsPerReader, itemCount,
+				[&](int item)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					return set.find(item % (itemCount * 2)) != set.end();
+				},
+				[&](int item)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					set.insert(item);
+				});
+		}
+
+		{
+			my::skip_list<int, std::less<int>, std::allocator<int>> list;
+
+			for (int i = 0; i < itemCount; i++)
+				list.insert(i * 2);
+
+			runLookups("my::skip_list", readerCount, lookupsPerReader, itemCount,
+				[&](int item) { return list.contains(item % (itemCount * 2)); },
+				[&](int item) { list.insert(item); });
+		}
+	}
+}
+
+// Single element allocations handed out from one arena in a random order, like a heap after a lot of churn.
+// Nothing is given back before the arena is reset.
+static std::vector<char>	s_arena;
+static std::vector<size_t>	s_arenaSlots;
+static size_t				s_arenaSlotSize = 0;
+static size_t				s_arenaNextSlot = 0;
+
+static void	resetArena(const size_t slotCount, const size_t slotSize)
+{
+	s_arena.assign(slotCount * slotSize, 0);
+	s_arenaSlots.resize(slotCount);
+
+	for (size_t i = 0; i < slotCount; i++)
+		s_arenaSlots[i] = i;
+
+	uint32_t seed = 0xC0FFEEu;
+
+	for (size_t i = slotCount - 1; i > 0; i--)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		std::swap(s_arenaSlots[i], s_arenaSlots[seed % (i + 1)]);
+	}
+
+	s_arenaSlotSize = slotSize;
+	s_arenaNextSlot = 0;
+}
+
+template <class T>
+struct ShuffledAllocator : std::allocator<T>
+{
+	ShuffledAllocator() = default;
+
+	template <class U>
+	ShuffledAllocator(const ShuffledAllocator<U>& other) {}
+
+	template <class U>
+	struct rebind
+	{
+		using other = ShuffledAllocator<U>;
+	};
+
+	// Only single nodes are taken from the arena, nothing is given back before the arena is dropped
+	T*		allocate(std::size_t n)
+	{
+		assert(n == 1);
+		(void)n;
+
+		return reinterpret_cast<T*>(&s_arena[s_arenaSlots[s_arenaNextSlot++] * s_arenaSlotSize]);
+	}
+
+	void	deallocate(T*, std::size_t) {}
+};
+
+struct BigItem
+{
+	BigItem(const int value) : m_value(value) {}
+
+	int		m_value;
+	char	m_padding[124];
+};
+
+static int	itemValue(const int item) { return item; }
+static int	itemValue(const BigItem& item) { return item.m_value; }
+
+// Sum the whole list a few times
+template <typename List>
+static void	runTraversals(const char* name, const List& list)
+{
+	const int	repeats = 5;
+	long long	expected = 0;
+
+	for (typename List::const_iterator it = list.begin(); it != list.end(); ++it)
+		expected += itemValue(*it);
+
+	long long sum = 0;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int r = 0; r < repeats; r++)
+	{
+		for (typename List::const_iterator it = list.begin(); it != list.end(); ++it)
+			sum += itemValue(*it);
+	}
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	REQUIRE(sum == expected * repeats);
+
+	std::printf("%-28s %6.2f ns/node\n", name, seconds * 1e9 / (static_cast<double>(list.size()) * repeats));
+}
+
+template <typename T>
+static void	runListTraversals(const char* name, const int itemCount)
+{
+	{
+		my::list<T, std::allocator<T>> list;
+
+		for (int i = 0; i < itemCount; i++)
+			list.push_back(T(i));
+
+		std::printf("\n%s, allocation order\n", name);
+		runTraversals("my::list", list);
+	}
+
+	{
+		// Room for the node with its links, rounded to a cache line
+		resetArena(itemCount, (sizeof(T) + 3 * sizeof(void*) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+
+		my::list<T, ShuffledAllocator<T>> list;
+
+		for (int i = 0; i < itemCount; i++)
+			list.push_back(T(i));
+
+		std::printf("\n%s, shuffled allocation order\n", name);
+		runTraversals("my::list", list);
+	}
+
+	s_arena = std::vector<char>();
+	s_arenaSlots = std::vector<size_t>();
+}
+
+TEST_CASE("Benchmark_ListTraversal", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_ListTraversal================\n");
+
+	const int itemCount = 1 << 21;
+
+	runListTraversals<int>("int", itemCount);
+	runListTraversals<BigItem>("128 bytes item", itemCount / 2);
+}
+
+
+
+typedef my::basic_string<char, std::allocator<char>> BenchString;
+
+// Log line fragments, 4 dates then 4 levels, 4 modules, 4 messages and 4 thread names
+static const char* const	s_logFragments[] =
+{
+	"2024-03-01 08:15:02.114", "2024-03-01 08:15:02.387", "2024-03-01 08:15:03.020", "2024-03-01 08:15:04.951",
+	"DEBUG", "INFO", "WARN", "ERROR",
+	"storage", "network", "scheduler", "renderer",
+	"request served", "cache miss on a cold key", "retrying the connection after a timeout",
+	"frame took longer than its budget",
+	"main", "worker-1", "worker-2", "io"
+};
+
+template <typename String>
+static std::vector<String>	makeLogFragments()
+{
+	std::vector<String> fragments;
+
+	for (const char* fragment : s_logFragments)
+		fragments.push_back(String(fragment));
+
+	return fragments;
+}
+
+template <typename Build>
+static void	runLogLines(const char* name, const int lineCount, Build build)
+{
+	size_t totalSize = 0;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int i = 0; i < lineCount; i++)
+		totalSize += build(i);
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	std::printf("%-32s %8.1f ns/line   %llu chars\n", name, seconds * 1e9 / lineCount,
+		static_cast<unsigned long long>(totalSize));
+}
+
+TEST_CASE("Benchmark_StringConcat", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_StringConcat================\n");
+
+	const int lineCount = 1 << 20;
+
+	const std::vector<std::string> stdParts = makeLogFragments<std::string>();
+	const std::vector<BenchString> myParts = makeLogFragments<BenchString>();
+
+	// Fragment of the given group, picked from the line index
+	auto part = [](const int group, const int i) { return group * 4 + ((i >> group) & 3); };
+
+	std::printf("\n5 fragments\n");
+
+	runLogLines("std::string operator+", lineCount, [&](const int i)
+	{
+		const std::string line = stdParts[part(0, i)] + stdParts[part(1, i)] + stdParts[part(2, i)] +
+			stdParts[part(3, i)] + "\n";
+		return line.size();
+	});
+
+	runLogLines("my::string operator+", lineCount, [&](const int i)
+	{
+		const BenchString line = myParts[part(0, i)] + myParts[part(1, i)] + myParts[part(2, i)] +
+			myParts[part(3, i)] + "\n";
+		return line.size();
+	});
+
+	runLogLines("my::concat", lineCount, [&](const int i)
+	{
+		const BenchString line = my::concat<char, std::allocator<char>>(myParts[part(0, i)], myParts[part(1, i)],
+			myParts[part(2, i)], myParts[part(3, i)], '\n');
+		return line.size();
+	});
+
+	std::printf("\n10 fragments\n");
+
+	runLogLines("std::string operator+", lineCount, [&](const int i)
+	{
+		const std::string line = stdParts[part(0, i)] + " " + stdParts[part(1, i)] + " [" + stdParts[part(2, i)] +
+			"] " + stdParts[part(3, i)] + " (" + stdParts[part(4, i)] + ")\n";
+		return line.size();
+	});
+
+	runLogLines("my::string operator+", lineCount, [&](const int i)
+	{
+		const BenchString line = myParts[part(0, i)] + " " + myParts[part(1, i)] + " [" + myParts[part(2, i)] +
+			"] " + myParts[part(3, i)] + " (" + myParts[part(4, i)] + ")\n";
+		return line.size();
+	});
+
+	runLogLines("my::concat", lineCount, [&](const int i)
+	{
+		const BenchString line = my::concat<char, std::allocator<char>>(myParts[part(0, i)], ' ', myParts[part(1, i)],
+			" [", myParts[part(2, i)], "] ", myParts[part(3, i)], " (", myParts[part(4, i)], ")\n");
+		return line.size();
+	});
+}
+
+template <typename Find>
+static void	runFinds(const char* name, const size_t haystackSize, Find find)
+{
+	const int repeats = 10;
+
+	size_t found = 0;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int r = 0; r < repeats; r++)
+		found += find();
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	REQUIRE(found != 0);
+
+	std::printf("%-32s %8.2f GB/s\n", name, static_cast<double>(haystackSize) * repeats / seconds / 1e9);
+}
+
+TEST_CASE("Benchmark_StringFind", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_StringFind================\n");
+
+	// 8 MB of log lines, the needles only show up at the very end
+	std::string stdHaystack;
+
+	for (int i = 0; stdHaystack.size() < (8u << 20); i++)
+	{
+		stdHaystack += s_logFragments[i & 3];
+		stdHaystack += " INFO [network] request served in ";
+		stdHaystack += std::to_string(i % 997);
+		stdHaystack += " us\n";
+	}
+
+	const char* const needles[] =
+	{
+		"ERROR",
+		"connection reset by peer",
+		"request served in 1000 us", // Its first chars are everywhere in the haystack
+		"worker-3 lost its connection to the storage node"
+	};
+
+	for (const char* needle : needles)
+		stdHaystack += needle;
+
+	const BenchString myHaystack(stdHaystack.c_str(), stdHaystack.size());
+
+	for (const char* needle : needles)
+	{
+		std::printf("\n%llu chars needle\n", static_cast<unsigned long long>(std::strlen(needle)));
+
+		const std::string stdNeedle = needle;
+		const BenchString myNeedle = needle;
+
+		runFinds("std::string::find", stdHaystack.size(), [&]() { return stdHaystack.find(stdNeedle); });
+		runFinds("my::string::find", myHaystack.size(), [&]() { return myHaystack.find(myNeedle); });
+	}
+}
+
+template <typename Map, typename Key>
+static void	runLookups(const char* name, const Map& map, const std::vector<Key>& keys, const int lookupCount)
+{
+	int found = 0;
+
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int i = 0; i < lookupCount; i++)
+		found += map.count(keys[i % keys.size()]) != 0;
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	REQUIRE(found == lookupCount);
+
+	std::printf("%-32s %8.1f ns/lookup\n", name, seconds * 1e9 / lookupCount);
+}
+
+TEST_CASE("Benchmark_StringHash", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_StringHash================\n");
+
+	const int keyCount = 1000;
+	const int lookupCount = 2000000;
+
+	// Module names, log lines, then whole paragraphs as keys
+	const size_t lengths[] = { 8, 64, 512 };
+
+	for (const size_t length : lengths)
+	{
+		std::printf("\n%llu chars keys\n", static_cast<unsigned long long>(length));
+
+		std::vector<std::string> stdKeys;
+		std::vector<BenchString> myKeys;
+
+		for (int i = 0; i < keyCount; i++)
+		{
+			std::string key = std::to_string(i) + " ";
+
+			while (key.size() < length)
+				key += s_logFragments[(i + key.size()) % 20];
+
+			key.resize(length);
+
+			stdKeys.push_back(key);
+			myKeys.push_back(BenchString(key.c_str(), key.size()));
+		}
+
+		std::unordered_map<std::string, int> stdMap;
+		std::unordered_map<BenchString, int> myMap;
+
+		for (int i = 0; i < keyCount; i++)
+		{
+			stdMap[stdKeys[i]] = i;
+			myMap[myKeys[i]] = i;
+		}
+
+		// The same key objects are looked up again and again, as with a long lived identifier
+		runLookups("std::unordered_map<std::string>", stdMap, stdKeys, lookupCount);
+		runLookups("std::unordered_map<my::string>", myMap, myKeys, lookupCount);
+	}
+}
+
+template <typename Edit>
+static void	runEdits(const char* name, const int editCount, Edit edit)
+{
+	const BenchClock::time_point start = BenchClock::now();
+
+	for (int i = 0; i < editCount; i++)
+		edit(i);
+
+	const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	std::printf("%-32s %8.1f us/edit\n", name, seconds * 1e6 / editCount);
+}
+
+TEST_CASE("Benchmark_RopeEdit", "[.][benchmark]")
+{
+	std::printf("\n=======Benchmark_RopeEdit================\n");
+
+	typedef my::basic_rope<char, std::allocator<char>> BenchRope;
+
+	const int editCount = 2000;
+
+	// An 8 MB document, typed into and cut from all over
+	std::string stdText;
+
+	for (int i = 0; stdText.size() < (8u << 20); i++)
+	{
+		stdText += s_logFragments[i & 3];
+		stdText += " INFO [network] request served\n";
+	}
+
+	BenchRope rope(my::basic_string_view<char>(stdText.c_str(), stdText.size()));
+
+	runEdits("std::string insert and erase", editCount, [&](const int i)
+	{
+		const size_t pos = static_cast<size_t>(i) * 7919 * 1031 % stdText.size();
+
+		if (i % 2 == 0)
+			stdText.insert(pos, "typed ");
+		else
+			stdText.erase(pos, 6);
+	});
+
+	runEdits("my::rope insert and erase", editCount, [&](const int i)
+	{
+		const size_t pos = static_cast<size_t>(i) * 7919 * 1031 % rope.size();
+
+		if (i % 2 == 0)
+			rope.insert(pos, "typed ");
+		else
+			rope.erase(pos, 6);
+	});
+
+	REQUIRE(rope.size() == stdText.size());
+
+	runEdits("my::rope copy then insert", editCount, [&](const int i)
+	{
+		// A snapshot per edit, as an undo history would keep
+		BenchRope snapshot = rope;
+		snapshot.insert(static_cast<size_t>(i) * 7919 % rope.size(), "undo ");
+	});
+
+	runEdits("my::rope flatten", 10, [&](int)
+	{
+		REQUIRE(rope.flatten().size() == stdText.size());
+	});
+}
\ No newline at end of file
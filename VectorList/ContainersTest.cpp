@@ -1,12 +1,29 @@
 
 #include "pch.h"
 #include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "catch.hpp"
 
 #include "SpyAllocator.h"
 #include "Foo.h"
 #include "MonContainer.h"
+#include "MyCache.h"
+#include "MyCompactList.h"
+#include "MyConcurrentQueue.h"
+#include "MyDeque.h"
+#include "MyInternTable.h"
+#include "MyIntrusiveList.h"
+#include "MyList.h"
+#include "MyRingBuffer.h"
+#include "MyRope.h"
+#include "MySkipList.h"
+#include "MyString.h"
+#include "MyStringView.h"
+#include "StringSimd.h"
+#include "ThreadCacheAllocator.h"
 
 
 
@@ -612,64 +629,2360 @@ TEST_CASE("List_Rvalues_Variadics", "[VectorList]")
 }
 
 
-/* String */
-TEST_CASE("String", "[VectorList]")
+// Throws from its copy constructor once s_copiesLeft copies were made, never while it is negative
+struct ThrowingCopy
 {
-	std::printf("\n=======Strings================\n");
+	explicit ThrowingCopy(int value) : m_value(value)
+	{
+	}
 
+	ThrowingCopy(const ThrowingCopy& other) : m_value(other.m_value)
 	{
+		if (s_copiesLeft == 0)
+			throw std::runtime_error("Copy failed");
 
-		std::printf("Sizeof String : %llu\n", sizeof(string));
+		if (s_copiesLeft > 0)
+			s_copiesLeft--;
+	}
 
-		{
-			DO(string s);
-			std::printf("Length of s : %llu\n", s.length());
-		}
+	int			m_value;
+	static int	s_copiesLeft;
+};
 
-		{
-			DO(string s = "Moins de 16 car");
-			std::printf("Length of s : %llu\n", s.length());
-		}
+int ThrowingCopy::s_copiesLeft = -1;
+
+/* Batch insert: count and range inserts allocate all their nodes at once */
+TEST_CASE("List_BatchInsert", "[VectorList]")
+{
+	std::printf("\n=======List_BatchInsert================\n");
+
+	Foo::ResetCount();
+
+	{
+		my::list<Foo> fooList;
+
+		DO(fooList.push_back((const Foo&)Foo()));
+		DO(fooList.push_back((const Foo&)Foo()));
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		DO(my::list<Foo>::iterator it = fooList.insert(++fooList.begin(), 3, (const Foo&)Foo()));
+
+		// The nodes and the chunk bookkeeping in a single block, whatever the count
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1);
+		REQUIRE(fooList.size() == 5);
+		REQUIRE(it->MyCount() == 5);
+		REQUIRE((++it)->MyCount() == 6);
+		REQUIRE((++it)->MyCount() == 7);
+		REQUIRE((++it)->MyCount() == 3);
+		REQUIRE(fooList.back().MyCount() == 3);
+
+		std::printf("\nDestroy list\n\n");
+	}
+
+	{
+		my::list<int> intList;
+
+		DO(intList.push_back(1));
+
+		const int items[] = { 2, 3, 4, 5 };
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		DO(my::list<int>::iterator it = intList.insert(intList.end(), std::begin(items), std::end(items)));
+
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1);
+		REQUIRE(intList.size() == 5);
+		REQUIRE(*it == 2);
+		REQUIRE(intList.back() == 5);
+
+		// Freeing part of a batch keeps the block alive for the remaining nodes
+		blockCount = g_memorySpy.BlockCount();
+
+		DO(intList.remove(3));
+		DO(intList.remove(5));
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		DO(intList.remove(2));
+		DO(intList.remove(4));
+		REQUIRE(g_memorySpy.BlockCount() == blockCount - 1);
+		REQUIRE(intList.size() == 1);
+		REQUIRE(intList.front() == 1);
+
+		DO(intList.insert(intList.begin(), 2, 0));
+		REQUIRE(intList.size() == 3);
+		REQUIRE(intList.back() == 1);
+
+		std::printf("\nDestroy list\n\n");
+	}
+
+	{
+		// A copy throwing halfway through a batch gives back the nodes built so far and their block
+		my::list<ThrowingCopy> throwingList;
+		const ThrowingCopy items[] = { ThrowingCopy(1), ThrowingCopy(2), ThrowingCopy(3) };
+
+		DO(throwingList.push_back(ThrowingCopy(0)));
+
+		const size_t blockCount = g_memorySpy.BlockCount();
+
+		ThrowingCopy::s_copiesLeft = 2;
+		REQUIRE_THROWS(throwingList.insert(throwingList.end(), 5, ThrowingCopy(1)));
+		REQUIRE(throwingList.size() == 1);
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		ThrowingCopy::s_copiesLeft = 1;
+		REQUIRE_THROWS(throwingList.insert(throwingList.end(), std::begin(items), std::end(items)));
+		REQUIRE(throwingList.size() == 1);
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		// Past the first chunk of a copy, the chunks already linked are freed too
+		ThrowingCopy::s_copiesLeft = -1;
+		DO(throwingList.insert(throwingList.end(), LIST_COPY_CHUNK_SIZE + 10, ThrowingCopy(2)));
+
+		const size_t filledBlockCount = g_memorySpy.BlockCount();
+
+		ThrowingCopy::s_copiesLeft = LIST_COPY_CHUNK_SIZE + 5;
+		REQUIRE_THROWS(my::list<ThrowingCopy>(throwingList));
+		REQUIRE(g_memorySpy.BlockCount() == filledBlockCount);
+
+		ThrowingCopy::s_copiesLeft = -1;
+		REQUIRE(throwingList.back().m_value == 2);
+	}
+
+	REQUIRE(g_memorySpy.BlockCount() == 0);
+	g_memorySpy.CheckLeaks();
+}
+
+
+/* List.clear: tear down single and batch allocated nodes */
+TEST_CASE("List_Clear", "[VectorList]")
+{
+	std::printf("\n=======List_Clear================\n");
+
+	Foo::ResetCount();
 
+	{
+		my::list<Foo> fooList;
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		DO(fooList.push_back(Foo()));
+		DO(fooList.insert(fooList.begin(), 3, (const Foo&)Foo()));
+		DO(fooList.push_back(Foo()));
+
+		REQUIRE(fooList.size() == 5);
+
+		DO(fooList.clear());
+
+		REQUIRE(fooList.size() == 0);
+		REQUIRE(fooList.begin() == fooList.end());
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		DO(fooList.clear());
+
+		// The list is usable again once cleared
+		DO(fooList.push_back(Foo()));
+		REQUIRE(fooList.size() == 1);
+		REQUIRE(&fooList.front() == &fooList.back());
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+TEST_CASE("List_RemoveIf_Unique", "[VectorList]")
+{
+	std::printf("\n=======List_RemoveIf_Unique================\n");
+
+	{
+		my::list<int> intList;
+
+		for (int i = 0; i < 10; i++)
+			intList.push_back(i);
+
+		DO(intList.remove_if([](const int& item) { return item % 3 == 0; }));
+		REQUIRE(intList.size() == 6);
+		REQUIRE(intList.front() == 1);
+		REQUIRE(intList.back() == 8);
+
+		DO(intList.remove(8));
+		REQUIRE(intList.back() == 7);
+
+		// Only consecutive duplicates are dropped
+		const int values[] = { 1, 1, 2, 2, 2, 3, 1, 1 };
+
+		DO(intList.clear());
+		DO(intList.insert(intList.end(), values, values + 8));
+		DO(intList.unique());
+
+		const int expected[] = { 1, 2, 3, 1 };
+		size_t i = 0;
+
+		REQUIRE(intList.size() == 4);
+
+		for (int item : intList)
+			REQUIRE(item == expected[i++]);
+
+		// Compared with the last element kept, not the previous one
+		DO(intList.unique([](const int& kept, const int& item) { return item < kept + 2; }));
+		REQUIRE(intList.size() == 2);
+		REQUIRE(intList.front() == 1);
+		REQUIRE(intList.back() == 3);
+
+		DO(intList.remove_if([](const int&) { return true; }));
+		REQUIRE(intList.size() == 0);
+		REQUIRE(intList.begin() == intList.end());
+	}
+
+	{
+		// Large enough to prefetch, kept away from the memory spy output
+		my::list<int, std::allocator<int>> intList;
+
+		for (int i = 0; i < LIST_PREFETCH_MIN_SIZE * 2; i++)
+			intList.push_back(i / 2);
+
+		intList.unique();
+		REQUIRE(intList.size() == LIST_PREFETCH_MIN_SIZE);
+
+		intList.remove_if([](const int& item) { return item % 2 == 1; });
+		REQUIRE(intList.size() == LIST_PREFETCH_MIN_SIZE / 2);
+	}
+
+	{
+		// A throwing predicate leaves the list with what was kept so far, nothing leaks
+		my::list<int> intList;
+
+		for (int i = 0; i < 10; i++)
+			intList.push_back(i / 2);
+
+		REQUIRE_THROWS_AS(intList.remove_if([](const int& item)
 		{
-			DO(string s = "Plus de 16 car, 27 au total");
-			std::printf("Length of s : %llu\n", s.length());
-		}
+			if (item == 3)
+				throw std::runtime_error("remove_if");
+
+			return item % 2 == 0;
+		}), std::runtime_error);
+		REQUIRE(intList.size() == 6);
+		REQUIRE(intList.front() == 1);
 
+		REQUIRE_THROWS_AS(intList.unique([](const int& kept, const int& item)
 		{
-			DO(string s = "Plus de 32 car, 34 pour etre exact");
-			std::printf("Length of s : %llu\n", s.length());
-		}
+			if (item == 4)
+				throw std::runtime_error("unique");
+
+			return kept == item;
+		}), std::runtime_error);
+		REQUIRE(intList.size() == 4);
+		REQUIRE(intList.front() == 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+TEST_CASE("List_NodeHandle", "[VectorList]")
+{
+	std::printf("\n=======List_NodeHandle================\n");
+
+	Foo::ResetCount();
+
+	{
+		my::list<Foo> ready;
+		my::list<Foo> waiting;
+		my::list<Foo> done;
+
+		DO(ready.push_back(Foo(1)));
+		DO(ready.insert(ready.end(), 2, (const Foo&)Foo(2)));
+		DO(ready.push_back(Foo(3)));
+
+		const int firstId = ready.front().MyCount();
+		const Foo* first = &ready.front();
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		// Moving between lists neither allocates nor touches the element
+		DO(my::list<Foo>::node_type node = ready.extract(ready.begin()));
+		REQUIRE(ready.size() == 3);
+		REQUIRE(!node.empty());
+		REQUIRE(&node.value() == first);
+
+		DO(waiting.insert(waiting.end(), std::move(node)));
+		REQUIRE(node.empty());
+		REQUIRE(&waiting.front() == first);
+
+		DO(done.insert(done.begin(), waiting.extract(waiting.begin())));
+		REQUIRE(waiting.size() == 0);
+		REQUIRE(done.size() == 1);
+		REQUIRE(&done.front() == first);
+		REQUIRE(done.front().MyCount() == firstId);
+
+		// Nodes of a batch insert move around just the same
+		DO(done.insert(done.end(), ready.extract(++ready.begin())));
+		DO(done.insert(done.begin(), ready.extract(ready.begin())));
+		REQUIRE(ready.size() == 1);
+		REQUIRE(done.size() == 3);
+		REQUIRE(&*++done.begin() == first);
+
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		// An empty handle inserts nothing
+		DO(my::list<Foo>::iterator it = done.insert(done.begin(), my::list<Foo>::node_type()));
+		REQUIRE(it == done.begin());
+		REQUIRE(done.size() == 3);
+
+		// A handle dropped on the floor destroys its element
+		std::printf("\nDrop an extracted node\n\n");
+		DO(ready.extract(ready.begin()));
+		REQUIRE(ready.size() == 0);
+		REQUIRE(ready.begin() == ready.end());
+
+		REQUIRE_THROWS(ready.extract(ready.end()));
+		REQUIRE_THROWS(my::list<Foo>::node_type().value());
+	}
+
+	g_memorySpy.CheckLeaks();
+}
 
+// Fails once FailingAllocation::s_allocationsLeft allocations were made, never while it is negative
+struct FailingAllocation
+{
+	static int	s_allocationsLeft;
+};
+
+int FailingAllocation::s_allocationsLeft = -1;
+
+template <class T>
+struct FailingAllocator : SpyAllocator<T>
+{
+	FailingAllocator() = default;
+
+	template <class U>
+	FailingAllocator(const FailingAllocator<U>& other) {}
+
+	template <class U>
+	struct rebind
+	{
+		using other = FailingAllocator<U>;
+	};
+
+	T*		allocate(std::size_t n)
+	{
+		if (FailingAllocation::s_allocationsLeft == 0)
+			throw std::bad_alloc();
+
+		if (FailingAllocation::s_allocationsLeft > 0)
+			FailingAllocation::s_allocationsLeft--;
+
+		return SpyAllocator<T>::allocate(n);
+	}
+};
+
+TEST_CASE("List_ChunkedCopy", "[VectorList]")
+{
+	std::printf("\n=======List_ChunkedCopy================\n");
+
+	{
+		const int itemCount = LIST_COPY_CHUNK_SIZE * 2 + 10;
+
+		std::vector<int> values;
+
+		for (int i = 0; i < itemCount; i++)
+			values.push_back(i);
+
+		my::list<int> source;
+		DO(source.insert(source.end(), values.begin(), values.end()));
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		// Three chunks, each a single block
+		DO(my::list<int> copy(source));
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 3);
+		REQUIRE(copy.size() == source.size());
+		REQUIRE(std::equal(copy.begin(), copy.end(), values.begin()));
+		REQUIRE(copy.back() == itemCount - 1);
+
+		// One chunk per worker
+		DO(my::list<int> parallelCopy(source, 4));
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 7);
+		REQUIRE(parallelCopy.size() == source.size());
+		REQUIRE(std::equal(parallelCopy.begin(), parallelCopy.end(), values.begin()));
+		REQUIRE(parallelCopy.back() == itemCount - 1);
+
+		// Walks backward across chunks too
+		my::list<int>::iterator it = std::next(parallelCopy.begin(), (itemCount + 3) / 4);
+		REQUIRE(*it == (itemCount + 3) / 4);
+		REQUIRE(*--it == (itemCount + 3) / 4 - 1);
+
+		DO(parallelCopy.push_back(-1));
+		DO(parallelCopy = source);
+		REQUIRE(parallelCopy.size() == source.size());
+		REQUIRE(parallelCopy.back() == itemCount - 1);
+	}
+
+	{
+		my::list<Foo> fooList;
+
+		DO(fooList.push_back(Foo()));
+		DO(fooList.push_back(Foo()));
+		DO(fooList.push_back(Foo()));
+
+		// More workers than elements falls back to a single chunk
+		DO(my::list<Foo> copy(fooList, 8));
+		REQUIRE(copy.size() == 3);
+
+		std::printf("\nDestroy lists\n\n");
+	}
+
+	{
+		typedef std::vector<int, SpyAllocator<int>> IntVector;
+
+		my::list<IntVector> vectorList;
+
+		for (int i = 0; i < 100; i++)
+			vectorList.push_back(IntVector(3, i));
+
+		// Copying the vectors allocates, it stays on this thread whatever the worker count
+		const size_t blockCount = g_memorySpy.BlockCount();
+
+		my::list<IntVector> copy(vectorList, 4);
+		REQUIRE(copy.size() == 100);
+		REQUIRE(copy.back() == IntVector(3, 99));
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1 + 100);
+	}
+
+	{
+		my::list<int, FailingAllocator<int>> source;
+
+		for (int i = 0; i < 100; i++)
+			source.push_back(i);
+
+		const size_t blockCount = g_memorySpy.BlockCount();
+
+		// The third of four chunks can't be allocated, no worker starts and the first two are freed
+		FailingAllocation::s_allocationsLeft = 2;
+		REQUIRE_THROWS_AS((my::list<int, FailingAllocator<int>>(source, 4)), std::bad_alloc);
+		FailingAllocation::s_allocationsLeft = -1;
+
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		my::list<int, FailingAllocator<int>> copy(source, 4);
+		REQUIRE(copy.size() == 100);
+		REQUIRE(copy.back() == 99);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Deque: both ends, random access, block reuse */
+TEST_CASE("Deque", "[VectorList]")
+{
+	std::printf("\n=======Deque================\n");
+
+	Foo::ResetCount();
+
+	{
+		my::deque<int> intDeque;
+
+		REQUIRE(intDeque.empty());
+		REQUIRE_THROWS(intDeque.front());
+		REQUIRE_THROWS(intDeque.pop_back());
+
+		DO(intDeque.push_back(1));
+		DO(intDeque.push_front(0));
+		DO(intDeque.emplace_back(2));
+		DO(intDeque.emplace_front(-1));
+
+		REQUIRE(intDeque.size() == 4);
+		REQUIRE(intDeque.front() == -1);
+		REQUIRE(intDeque.back() == 2);
+		REQUIRE(intDeque[1] == 0);
+
+		// Enough to span a few blocks on both sides of the first element
+		const int count = static_cast<int>(my::deque<int>::blockSize) * 3;
+
+		for (int i = 0; i < count; i++)
 		{
-			DO(string s = "Plus de 48 car, 51 pour etre exact, bon ca suffit ?");
-			std::printf("Length of s : %llu\n", s.length());
+			intDeque.push_back(3 + i);
+			intDeque.push_front(-2 - i);
 		}
 
+		REQUIRE(intDeque.size() == static_cast<size_t>(count * 2 + 4));
+		REQUIRE(intDeque.end() - intDeque.begin() == count * 2 + 4);
+
+		int expected = -1 - count;
+
+		for (int item : intDeque)
+			REQUIRE(item == expected++);
+
+		my::deque<int>::iterator it = intDeque.begin() + count;
+		REQUIRE(*it == -1);
+		REQUIRE(it[2] == 1);
+		REQUIRE(*(it - 1) == -2);
+		REQUIRE(it < intDeque.end());
+
+		std::sort(intDeque.begin(), intDeque.end(), [](int a, int b) { return a > b; });
+		REQUIRE(intDeque.front() == count + 2);
+		REQUIRE(intDeque.back() == -1 - count);
+
+		// A queue of steady size runs on the blocks it already has
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		for (int i = 0; i < count * 10; i++)
 		{
-			DO(string s1 = "toto est vraiment une personne incroyable");
-			DO(string s2 = s1);
-			DO(s1[1] = 'a');
-			DO(s1[3] = 'a');
-			std::printf("s1 : %s\n", s1.c_str());
-			std::printf("s2 : %s\n", s2.c_str());
-			DO(s2 = s1);
-			DO(s2[3] = 'i');
-			std::printf("s1 : %s\n", s1.c_str());
-			std::printf("s2 : %s\n", s2.c_str());
+			intDeque.push_back(i);
+			intDeque.pop_front();
 		}
 
-		DO(string s1 = "Bonjour");
-		DO(string s2 = " le monde !");
-		DO(string s3 = s1 + s2);
-		std::printf("s3 : %s\n", s3.c_str());
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+		REQUIRE(intDeque.back() == count * 10 - 1);
 
-		std::printf("\nDestroy string\n\n");
+		for (int i = 0; i < count * 2 + 3; i++)
+			intDeque.pop_back();
+
+		REQUIRE(intDeque.size() == 1);
+		REQUIRE(intDeque.front() == intDeque.back());
+
+		// Spare blocks go back to the allocator
+		DO(intDeque.shrink_to_fit());
+		REQUIRE(g_memorySpy.BlockCount() < blockCount);
+		REQUIRE(intDeque.front() == count * 10 - count * 2 - 4);
+	}
+
+	{
+		my::deque<Foo> fooDeque;
+
+		DO(fooDeque.push_back(Foo()));
+		DO(fooDeque.push_front(Foo()));
+		DO(fooDeque.emplace_back(42));
+
+		DO(my::deque<Foo> copy(fooDeque));
+		REQUIRE(copy.size() == 3);
+		REQUIRE(copy.back().MyCount() != 42);
+
+		DO(my::deque<Foo> moved(std::move(copy)));
+		REQUIRE(copy.size() == 0);
+		REQUIRE(moved.size() == 3);
+
+		DO(fooDeque.pop_front());
+		DO(copy = fooDeque);
+		REQUIRE(copy.size() == 2);
+
+		std::printf("\nDestroy deques\n\n");
 	}
 
 	g_memorySpy.CheckLeaks();
 }
 
+/* Ring buffer: overwrite and reject modes, bulk transfers, span view */
+TEST_CASE("RingBuffer", "[VectorList]")
+{
+	std::printf("\n=======RingBuffer================\n");
+
+	Foo::ResetCount();
+
+	{
+		my::ring_buffer<int> window(5);
+
+		REQUIRE(window.capacity() == 8);
+		REQUIRE(window.empty());
+
+		for (int i = 0; i < 10; i++)
+			REQUIRE(window.push_back(i));
+
+		// The two oldest were dropped
+		REQUIRE(window.full());
+		REQUIRE(window.front() == 2);
+		REQUIRE(window.back() == 9);
+		REQUIRE(window[3] == 5);
+
+		// Wrapped around the end of the storage
+		my::ring_buffer<int>::span_pair parts = window.spans();
+		REQUIRE(parts.firstSize == 6);
+		REQUIRE(parts.secondSize == 2);
+		REQUIRE(parts.first[0] == 2);
+		REQUIRE(parts.second[1] == 9);
+
+		int items[8];
+		REQUIRE(window.pop_front(items, 3) == 3);
+		REQUIRE(items[0] == 2);
+		REQUIRE(items[2] == 4);
+		REQUIRE(window.size() == 5);
+
+		const int more[] = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+
+		// More than fits, only the newest are kept
+		REQUIRE(window.push_back(more, 11) == 8);
+		REQUIRE(window.front() == 13);
+		REQUIRE(window.back() == 20);
+
+		DO(window.consume(6));
+		REQUIRE(window.size() == 2);
+		REQUIRE(window.front() == 19);
+
+		DO(window.reserve(9));
+		REQUIRE(window.capacity() == 16);
+		REQUIRE(window.front() == 19);
+		REQUIRE(window.back() == 20);
+		REQUIRE(window.spans().secondSize == 0);
+	}
+
+	{
+		my::ring_buffer<int> queue(4, my::ring_buffer_mode::reject);
+
+		const int items[] = { 1, 2, 3, 4, 5, 6 };
+
+		REQUIRE(queue.push_back(items, 3) == 3);
+		REQUIRE(queue.push_back(items + 3, 3) == 1);
+		REQUIRE(!queue.push_back(7));
+		REQUIRE(queue.back() == 4);
+
+		queue.pop_front();
+		queue.pop_front();
+		REQUIRE(queue.push_back(items + 4, 2) == 2);
+
+		int popped[4];
+		REQUIRE(queue.pop_front(popped, 10) == 4);
+		REQUIRE(popped[0] == 3);
+		REQUIRE(popped[3] == 6);
+		REQUIRE(queue.empty());
+		REQUIRE_THROWS(queue.pop_front());
+	}
+
+	{
+		my::ring_buffer<Foo> fooBuffer(2);
+
+		DO(fooBuffer.push_back(Foo()));
+		DO(fooBuffer.emplace_back(42));
+
+		std::printf("\nOverwrite the oldest\n\n");
+		DO(fooBuffer.push_back(Foo()));
+		REQUIRE(fooBuffer.front().MyCount() == 42);
+
+		DO(my::ring_buffer<Foo> copy(fooBuffer));
+		DO(my::ring_buffer<Foo> moved(std::move(fooBuffer)));
+		REQUIRE(moved.size() == 2);
+		REQUIRE(fooBuffer.capacity() == 0);
+		REQUIRE(!fooBuffer.push_back(Foo()));
+
+		DO(fooBuffer = copy);
+		REQUIRE(fooBuffer.size() == 2);
+
+		std::printf("\nDestroy buffers\n\n");
+	}
+
+	{
+		my::ring_buffer<std::string> strings(2);
+
+		strings.push_back(std::string(40, 'a'));
+		strings.push_back(std::string(40, 'b'));
+
+		// The pushed element is the oldest one, the one dropped to make room
+		REQUIRE(strings.push_back(strings.front()));
+		REQUIRE(strings.back() == std::string(40, 'a'));
+		REQUIRE(strings.front() == std::string(40, 'b'));
+
+		REQUIRE(strings.push_back(std::move(strings.front())));
+		REQUIRE(strings.back() == std::string(40, 'b'));
+		REQUIRE(strings.front() == std::string(40, 'a'));
+	}
+
+	{
+		my::ring_buffer<std::string> strings(4);
+
+		for (char c = 'a'; c < 'e'; c++)
+			strings.push_back(std::string(40, c));
+
+		// Items read from the buffer itself, the oldest ones are dropped to make room for them
+		my::ring_buffer<std::string>::span_pair parts = strings.spans();
+		REQUIRE(strings.push_back(parts.first, 2) == 2);
+		REQUIRE(strings.front() == std::string(40, 'c'));
+		REQUIRE(strings[2] == std::string(40, 'a'));
+		REQUIRE(strings.back() == std::string(40, 'b'));
+
+		parts = strings.spans();
+		REQUIRE(strings.push_back(parts.first, parts.firstSize) == 2);
+		REQUIRE(strings.front() == std::string(40, 'a'));
+		REQUIRE(strings[1] == std::string(40, 'b'));
+		REQUIRE(strings[2] == std::string(40, 'c'));
+		REQUIRE(strings.back() == std::string(40, 'd'));
+	}
+
+	{
+		my::ring_buffer<ThrowingCopy> buffer(4);
+		const ThrowingCopy items[] = { ThrowingCopy(1), ThrowingCopy(2), ThrowingCopy(3) };
+
+		buffer.push_back(items, 3);
+		buffer.pop_front();
+		buffer.pop_front();
+
+		// The free space wraps, the copy fails in its second part after one item was built there
+		ThrowingCopy::s_copiesLeft = 2;
+		REQUIRE_THROWS_AS(buffer.push_back(items, 3), std::runtime_error);
+		ThrowingCopy::s_copiesLeft = -1;
+
+		REQUIRE(buffer.size() == 2);
+		REQUIRE(buffer.back().m_value == 1);
+
+		// Same for a copy of a wrapped buffer, the storage of the copy is given back
+		buffer.push_back(items[2]);
+		REQUIRE(buffer.spans().secondSize == 1);
+
+		ThrowingCopy::s_copiesLeft = 2;
+		REQUIRE_THROWS_AS(my::ring_buffer<ThrowingCopy>(buffer), std::runtime_error);
+		ThrowingCopy::s_copiesLeft = -1;
+
+		my::ring_buffer<ThrowingCopy> copy(buffer);
+		REQUIRE(copy.size() == 3);
+		REQUIRE(copy.back().m_value == 3);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+
+/* Skip list: ordered insert, find, erase, readers running while a writer inserts */
+TEST_CASE("SkipList", "[VectorList]")
+{
+	std::printf("\n=======SkipList================\n");
+
+	{
+		my::skip_list<int> intList;
+
+		REQUIRE(intList.begin() == intList.end());
+		REQUIRE(intList.size() == 0);
+
+		const int items[] = { 50, 10, 40, 20, 30 };
+
+		for (int item : items)
+			REQUIRE(intList.insert(item));
+
+		DO(REQUIRE(!intList.insert(30)));
+		REQUIRE(intList.size() == 5);
+
+		// Iteration walks the items in order
+		int expected = 10;
+
+		for (my::skip_list<int>::iterator it = intList.begin(); it != intList.end(); ++it, expected += 10)
+			REQUIRE(*it == expected);
+
+		REQUIRE(*intList.find(40) == 40);
+		REQUIRE(intList.find(45) == intList.end());
+		REQUIRE(intList.contains(10));
+		REQUIRE(!intList.contains(0));
+
+		DO(REQUIRE(intList.erase(40)));
+		DO(REQUIRE(!intList.erase(40)));
+		REQUIRE(!intList.contains(40));
+		REQUIRE(intList.size() == 4);
+
+		DO(intList.collect());
+		REQUIRE(*(++intList.find(30)) == 50);
+
+		// Cleared nodes are only freed by collect, like erased ones
+		const size_t blockCount = g_memorySpy.BlockCount();
+
+		DO(intList.clear());
+		REQUIRE(intList.size() == 0);
+		REQUIRE(intList.begin() == intList.end());
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		DO(intList.collect());
+		REQUIRE(g_memorySpy.BlockCount() == blockCount - 4);
+
+		DO(REQUIRE(intList.insert(60)));
+		REQUIRE(*intList.begin() == 60);
+
+		std::printf("\nDestroy skip list\n\n");
+	}
+
+	{
+		const int itemCount = 2000;
+
+		my::skip_list<int, std::less<int>, std::allocator<int>> intList;
+
+		for (int i = 0; i < itemCount; i += 2)
+			intList.insert(i);
+
+		std::atomic<bool>	writing(true);
+		std::atomic<int>	missing(0);
+
+		std::vector<std::thread> readers;
+
+		for (int r = 0; r < 3; r++)
+		{
+			readers.emplace_back([&intList, &writing, &missing]()
+			{
+				// The even items are always there, whatever the writer is doing
+				do
+				{
+					for (int i = 0; i < itemCount; i += 2)
+					{
+						if (!intList.contains(i))
+							missing++;
+					}
+				}
+				while (writing.load());
+			});
+		}
+
+		for (int i = 1; i < itemCount; i += 2)
+			intList.insert(i);
+
+		for (int i = 1; i < itemCount; i += 4)
+			intList.erase(i);
+
+		writing = false;
+
+		for (std::thread& reader : readers)
+			reader.join();
+
+		REQUIRE(missing.load() == 0);
+		REQUIRE(intList.size() == itemCount - itemCount / 4);
+	}
+
+	{
+		// Readers walking the list while it is cleared under them
+		typedef my::skip_list<int, std::less<int>, std::allocator<int>> IntSkipList;
+
+		IntSkipList intList;
+
+		for (int i = 0; i < 1000; i++)
+			intList.insert(i);
+
+		std::atomic<bool>	clearing(true);
+		std::atomic<int>	unordered(0);
+
+		std::vector<std::thread> readers;
+
+		for (int r = 0; r < 3; r++)
+		{
+			readers.emplace_back([&intList, &clearing, &unordered]()
+			{
+				do
+				{
+					int previous = -1;
+
+					for (IntSkipList::iterator it = intList.begin(); it != intList.end(); ++it)
+					{
+						if (*it <= previous)
+							unordered++;
+
+						previous = *it;
+					}
+				}
+				while (clearing.load());
+			});
+		}
+
+		for (int round = 0; round < 20; round++)
+		{
+			intList.clear();
+
+			for (int i = 0; i < 1000; i++)
+				intList.insert(i);
+		}
+
+		clearing = false;
+
+		for (std::thread& reader : readers)
+			reader.join();
+
+		REQUIRE(unordered.load() == 0);
+		REQUIRE(intList.size() == 1000);
+
+		DO(intList.collect());
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+
+/* Compact list: index links, slot recycling, relocation */
+TEST_CASE("CompactList", "[VectorList]")
+{
+	std::printf("\n=======CompactList================\n");
+
+	Foo::ResetCount();
+
+	{
+		my::compact_list<Foo> fooList;
+
+		REQUIRE(fooList.begin() == fooList.end());
+		REQUIRE(fooList.size() == 0);
+
+		DO(fooList.reserve(4));
+		DO(fooList.push_back((const Foo&)Foo()));
+		DO(fooList.push_back(Foo()));
+		DO(fooList.emplace_back(42));
+
+		REQUIRE(fooList.size() == 3);
+		REQUIRE(fooList.front().MyCount() == 1);
+		REQUIRE(fooList.back().MyCount() == 42);
+
+		my::compact_list<Foo>::iterator it = fooList.begin();
+		REQUIRE((it++)->MyCount() == 1);
+		REQUIRE((it--)->MyCount() == 3);
+		REQUIRE(it->MyCount() == 1);
+
+		// Growing the slots array relocates the elements but keeps iterators valid
+		DO(++it);
+		DO(fooList.reserve(16));
+		REQUIRE(fooList.capacity() == 16);
+		REQUIRE(it->MyCount() == 5);
+
+		DO(it = fooList.insert(it, 2, (const Foo&)Foo()));
+		REQUIRE(fooList.size() == 5);
+		REQUIRE(it->MyCount() == 8);
+		REQUIRE((++it)->MyCount() == 9);
+		REQUIRE((++it)->MyCount() == 5);
+
+		DO(my::compact_list<Foo> fooCopy = fooList);
+		REQUIRE(fooCopy.size() == 5);
+		REQUIRE(fooCopy.capacity() == 5);
+
+		DO(my::compact_list<Foo> thiefList = std::move(fooCopy));
+		REQUIRE(fooCopy.size() == 0);
+		REQUIRE(fooCopy.begin() == fooCopy.end());
+		REQUIRE(thiefList.size() == 5);
+	}
+
+	{
+		my::compact_list<int> intList;
+
+		for (int i = 0; i < 8; i++)
+			intList.push_back(i);
+
+		size_t capacity = intList.capacity();
+
+		DO(intList.remove(2));
+		DO(intList.remove(5));
+
+		// Freed slots are handed out again before the array grows
+		DO(intList.push_back(8));
+		DO(intList.push_back(9));
+		REQUIRE(intList.capacity() == capacity);
+		REQUIRE(intList.size() == 8);
+
+		const int expected[] = { 0, 1, 3, 4, 6, 7, 8, 9 };
+		size_t i = 0;
+
+		for (my::compact_list<int>::iterator item = intList.begin(); item != intList.end(); ++item)
+			REQUIRE(*item == expected[i++]);
+
+		DO(intList.clear());
+		REQUIRE(intList.size() == 0);
+		REQUIRE(intList.begin() == intList.end());
+		REQUIRE(intList.capacity() == capacity);
+	}
+
+	{
+		// Its own elements pushed while the array grows, they are copied before being relocated
+		const std::string text = "A string long enough to own a heap block";
+		my::compact_list<std::string> strings;
+
+		DO(strings.push_back(text));
+
+		for (int i = 0; i < 20; i++)
+		{
+			const size_t capacity = strings.capacity();
+
+			strings.push_back(strings.front());
+
+			if (i % 4 == 0)
+				strings.insert(strings.begin(), strings.back());
+
+			if (i % 4 == 1)
+				strings.insert(strings.end(), 3, strings.front());
+
+			if (i % 4 == 2)
+				strings.push_back(std::move(strings.back()));
+
+			if (strings.capacity() != capacity)
+				REQUIRE(strings.back() == text);
+		}
+
+		REQUIRE(strings.front() == text);
+		REQUIRE(std::count(strings.begin(), strings.end(), text) == static_cast<std::ptrdiff_t>(strings.size()) - 5);
+	}
+
+	{
+		// Removing by one of its own elements, every match goes, not only the first one
+		const std::string first = "A string long enough to own a heap block";
+		const std::string second = "Another string long enough to own a heap block";
+		my::compact_list<std::string> strings;
+
+		strings.push_back(first);
+		strings.push_back(second);
+		strings.push_back(first);
+		strings.push_back(first);
+
+		DO(strings.remove(strings.front()));
+		REQUIRE(strings.size() == 1);
+		REQUIRE(strings.front() == second);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+
+struct HookedFoo
+{
+	HookedFoo(int id) : m_id(id)
+	{
+	}
+
+	int								m_id;
+	my::intrusive_list_hook<HookedFoo>	m_hook;
+};
+
+typedef my::intrusive_list<HookedFoo, &HookedFoo::m_hook> HookedFooList;
+
+/* Intrusive list: push_back, insert, erase, splice, iterators */
+TEST_CASE("IntrusiveList", "[VectorList]")
+{
+	std::printf("\n=======IntrusiveList================\n");
+
+	{
+		HookedFoo foos[] = { 0, 1, 2, 3, 4, 5 };
+
+		HookedFooList ready;
+		HookedFooList done;
+
+		REQUIRE(ready.begin() == ready.end());
+		REQUIRE(ready.size() == 0);
+
+		DO(ready.push_back(foos[0]));
+		DO(ready.push_back(foos[2]));
+		DO(ready.insert(std::find_if(ready.begin(), ready.end(), [](const HookedFoo& foo) { return foo.m_id == 2; }), foos[1]));
+		DO(ready.push_front(foos[3]));
+
+		REQUIRE(ready.size() == 4);
+		REQUIRE(&ready.front() == &foos[3]);
+		REQUIRE(&ready.back() == &foos[2]);
+
+		HookedFooList::iterator it = ready.begin();
+		REQUIRE((it++)->m_id == 3);
+		REQUIRE((it++)->m_id == 0);
+		REQUIRE((it--)->m_id == 1);
+		REQUIRE(it->m_id == 0);
+
+		// Erasing gives back the following element and doesn't touch the object
+		it = ready.erase(it);
+		REQUIRE(it->m_id == 1);
+		REQUIRE(ready.size() == 3);
+		REQUIRE(foos[0].m_id == 0);
+
+		DO(done.push_back(foos[4]));
+		DO(done.push_back(foos[5]));
+
+		// Move a single element to the front of another list
+		DO(done.splice(done.begin(), ready, it));
+		REQUIRE(ready.size() == 2);
+		REQUIRE(done.size() == 3);
+		REQUIRE(&done.front() == &foos[1]);
+
+		// Move a whole list at once
+		DO(ready.splice(ready.end(), done));
+		REQUIRE(done.size() == 0);
+		REQUIRE(done.begin() == done.end());
+		REQUIRE(ready.size() == 5);
+
+		const int expected[] = { 3, 2, 1, 4, 5 };
+		size_t i = 0;
+
+		for (HookedFooList::iterator item = ready.begin(); item != ready.end(); ++item)
+			REQUIRE(item->m_id == expected[i++]);
+
+		REQUIRE(&ready.back() == &foos[5]);
+
+		DO(ready.remove(foos[5]));
+		REQUIRE(&ready.back() == &foos[4]);
+
+		// Elements can be linked again once the list is cleared
+		DO(ready.clear());
+		DO(done.push_back(foos[3]));
+		REQUIRE(done.size() == 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+
+/* Lock-free queues: bounded push, FIFO pop, concurrent producers */
+TEST_CASE("ConcurrentQueues", "[VectorList]")
+{
+	std::printf("\n=======ConcurrentQueues================\n");
+
+	Foo::ResetCount();
+
+	{
+		DO(my::mpsc_queue<Foo> mpscQueue(2));
+		DO(my::mpmc_queue<Foo> mpmcQueue(2));
+
+		REQUIRE(mpscQueue.capacity() == 2);
+		REQUIRE(mpmcQueue.capacity() == 2);
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		DO(REQUIRE(mpscQueue.push(Foo())));
+		DO(REQUIRE(mpscQueue.emplace(42)));
+		DO(REQUIRE(!mpscQueue.push(Foo())));
+
+		DO(REQUIRE(mpmcQueue.push(Foo())));
+		DO(REQUIRE(mpmcQueue.emplace(43)));
+		DO(REQUIRE(!mpmcQueue.push(Foo())));
+
+		// Nodes and cells are recycled, never allocated once the queues exist
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		Foo foo(0);
+
+		REQUIRE(mpscQueue.pop(foo));
+		REQUIRE(mpscQueue.pop(foo));
+		REQUIRE(!mpscQueue.pop(foo));
+		DO(REQUIRE(mpscQueue.push(Foo())));
+
+		REQUIRE(mpmcQueue.pop(foo));
+		REQUIRE(mpmcQueue.pop(foo));
+		REQUIRE(!mpmcQueue.pop(foo));
+		DO(REQUIRE(mpmcQueue.push(Foo())));
+
+		std::printf("\nDestroy queues with one element left\n\n");
+	}
+
+	{
+		// A queue without capacity rejects every push
+		DO(my::mpsc_queue<int> emptyQueue(0));
+		REQUIRE(emptyQueue.capacity() == 0);
+		REQUIRE(!emptyQueue.push(1));
+
+		int item = 0;
+		REQUIRE(!emptyQueue.pop(item));
+	}
+
+	{
+		const int		producerCount = 4;
+		const int		itemsPerProducer = 10000;
+
+		my::mpsc_queue<int>	mpscQueue(64);
+		my::mpmc_queue<int>	mpmcQueue(64);
+
+		std::vector<std::thread> threads;
+
+		for (int p = 0; p < producerCount; p++)
+		{
+			threads.emplace_back([&mpscQueue, &mpmcQueue, p]()
+			{
+				for (int i = 0; i < itemsPerProducer; i++)
+				{
+					while (!mpscQueue.push(p * itemsPerProducer + i))
+						std::this_thread::yield();
+
+					while (!mpmcQueue.push(p * itemsPerProducer + i))
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		std::atomic<long long>	mpmcSum(0);
+		std::atomic<int>		mpmcCount(0);
+
+		for (int c = 0; c < 2; c++)
+		{
+			threads.emplace_back([&mpmcQueue, &mpmcSum, &mpmcCount]()
+			{
+				int item;
+
+				while (mpmcCount.load() < producerCount * itemsPerProducer)
+				{
+					if (mpmcQueue.pop(item))
+					{
+						mpmcSum += item;
+						mpmcCount++;
+					}
+				}
+			});
+		}
+
+		long long	mpscSum = 0;
+		int			last[producerCount] = { -1, -1, -1, -1 };
+		bool		ordered = true;
+		int			item;
+
+		for (int i = 0; i < producerCount * itemsPerProducer;)
+		{
+			if (!mpscQueue.pop(item))
+				continue;
+
+			// Items of a single producer come out in the order they were pushed
+			const int producer = item / itemsPerProducer;
+			ordered = ordered && item > last[producer];
+			last[producer] = item;
+
+			mpscSum += item;
+			i++;
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		const long long total = producerCount * itemsPerProducer;
+		const long long expectedSum = total * (total - 1) / 2;
+
+		REQUIRE(ordered);
+		REQUIRE(mpscSum == expectedSum);
+		REQUIRE(mpmcCount.load() == total);
+		REQUIRE(mpmcSum.load() == expectedSum);
+	}
+
+	{
+		DO(my::spsc_queue<Foo> spscQueue(3));
+		REQUIRE(spscQueue.capacity() == 4);
+
+		DO(REQUIRE(spscQueue.push(Foo())));
+		DO(REQUIRE(spscQueue.emplace(44)));
+
+		Foo foo(0);
+
+		REQUIRE(spscQueue.pop(foo));
+		std::printf("\nDestroy queue with one element left\n\n");
+	}
+
+	{
+		my::spsc_queue<int> spscQueue(64);
+
+		const int items[] = { 1, 2, 3, 4, 5 };
+		int popped[8];
+
+		REQUIRE(spscQueue.push(items, 5) == 5);
+		REQUIRE(spscQueue.pop(popped, 8) == 5);
+		REQUIRE(popped[4] == 5);
+		REQUIRE(!spscQueue.pop(popped[0]));
+
+		const int itemCount = 100000;
+
+		// Single items one way, batches the other way, both in order
+		std::thread producer([&spscQueue]()
+		{
+			int batch[16];
+
+			for (int i = 0; i < itemCount;)
+			{
+				int count = 0;
+
+				while (count < 16 && i + count < itemCount)
+				{
+					batch[count] = i + count;
+					count++;
+				}
+
+				i += static_cast<int>(spscQueue.push(batch, count));
+			}
+		});
+
+		bool	ordered = true;
+		int		next = 0;
+
+		while (next < itemCount)
+		{
+			int item;
+
+			if (spscQueue.pop(item))
+				ordered = ordered && item == next++;
+		}
+
+		producer.join();
+
+		REQUIRE(ordered);
+		REQUIRE(!spscQueue.pop(popped[0]));
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Caches: eviction order, byte capacity, hit/miss counters */
+TEST_CASE("Caches", "[VectorList]")
+{
+	std::printf("\n=======Caches================\n");
+
+	{
+		my::lru_cache<int, int> cache(3);
+		std::vector<int>		evicted;
+
+		DO(cache.set_eviction_callback([&evicted](const int& key, int&) { evicted.push_back(key); }));
+
+		DO(REQUIRE(cache.insert(1, 10)));
+		DO(REQUIRE(cache.insert(2, 20)));
+		DO(REQUIRE(cache.insert(3, 30)));
+
+		// Using 1 makes 2 the least recently used entry
+		REQUIRE(*cache.find(1) == 10);
+		REQUIRE(cache.find(4) == nullptr);
+
+		DO(REQUIRE(cache.insert(4, 40)));
+		REQUIRE(cache.size() == 3);
+		REQUIRE(evicted.size() == 1);
+		REQUIRE(evicted[0] == 2);
+		REQUIRE(!cache.contains(2));
+
+		// Updating an entry doesn't evict and refreshes it
+		DO(REQUIRE(cache.insert(3, 33)));
+		REQUIRE(evicted.size() == 1);
+		REQUIRE(*cache.find(3) == 33);
+
+		REQUIRE(cache.hits() == 2);
+		REQUIRE(cache.misses() == 1);
+
+		// Erasing isn't an eviction
+		REQUIRE(cache.erase(1));
+		REQUIRE(!cache.erase(1));
+		REQUIRE(evicted.size() == 1);
+		REQUIRE(cache.size() == 2);
+
+		// Grow the index well past its first table through many evictions
+		for (int i = 100; i < 1100; i++)
+			cache.insert(i, i);
+
+		REQUIRE(cache.size() == 3);
+		REQUIRE(*cache.find(1099) == 1099);
+		REQUIRE(*cache.find(1097) == 1097);
+		REQUIRE(!cache.contains(1096));
+	}
+
+	{
+		struct Length
+		{
+			size_t operator()(const int&, const std::vector<char>& value) const { return value.size(); }
+		};
+
+		my::lru_cache<int, std::vector<char>, std::hash<int>, Length> cache(10, my::cache_capacity::bytes);
+
+		DO(REQUIRE(cache.insert(1, std::vector<char>(4))));
+		DO(REQUIRE(cache.insert(2, std::vector<char>(4))));
+		REQUIRE(cache.used() == 8);
+
+		// Needs to drop the oldest entry to fit
+		DO(REQUIRE(cache.insert(3, std::vector<char>(4))));
+		REQUIRE(cache.used() == 8);
+		REQUIRE(!cache.contains(1));
+
+		// Too big to ever fit
+		DO(REQUIRE(!cache.insert(4, std::vector<char>(11))));
+		REQUIRE(cache.size() == 2);
+	}
+
+	{
+		my::lfu_cache<int, int> cache(3);
+		std::vector<int>		evicted;
+
+		DO(cache.set_eviction_callback([&evicted](const int& key, int&) { evicted.push_back(key); }));
+
+		DO(cache.insert(1, 10));
+		DO(cache.insert(2, 20));
+		DO(cache.insert(3, 30));
+
+		cache.find(1);
+		cache.find(1);
+		cache.find(3);
+
+		REQUIRE(cache.frequency(1) == 3);
+		REQUIRE(cache.frequency(2) == 1);
+		REQUIRE(cache.frequency(3) == 2);
+
+		// 2 is used the least
+		DO(cache.insert(4, 40));
+		REQUIRE(evicted.size() == 1);
+		REQUIRE(evicted[0] == 2);
+
+		// 4 is used the least, ties go to the least recent
+		DO(cache.insert(5, 50));
+		REQUIRE(evicted[1] == 4);
+
+		cache.find(5);
+		DO(cache.insert(6, 60));
+		REQUIRE(evicted[2] == 3);
+		REQUIRE(cache.frequency(3) == 0);
+
+		REQUIRE(cache.size() == 3);
+		REQUIRE(cache.hits() == 4);
+		REQUIRE(cache.misses() == 0);
+
+		DO(cache.clear());
+		REQUIRE(cache.size() == 0);
+		REQUIRE(!cache.contains(1));
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Thread cache allocator: node reuse, frees from other threads, trimming */
+TEST_CASE("ThreadCacheAllocator", "[VectorList]")
+{
+	std::printf("\n=======ThreadCacheAllocator================\n");
+
+	{
+		my::list<int, ThreadCacheAllocator<int>> intList;
+
+		DO(intList.push_back(1));
+
+		size_t blockCount = g_memorySpy.BlockCount();
+
+		for (int i = 2; i <= 10; i++)
+			intList.push_back(i);
+
+		DO(intList.clear());
+
+		// The nodes come back from the magazine, the heap isn't involved
+		for (int i = 0; i < 10; i++)
+			intList.push_back(i);
+
+		REQUIRE(intList.size() == 10);
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		// Free the nodes on another thread, they go back to this thread's cache
+		std::thread([&intList]() { intList.clear(); }).join();
+
+		REQUIRE(intList.size() == 0);
+
+		for (int i = 0; i < 10; i++)
+			intList.push_back(i);
+
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+	}
+
+	{
+		typedef my::list<int, ThreadCacheAllocator<int, std::allocator<int>>> IntList;
+
+		const int	threadCount = 4;
+		const int	listsPerThread = 100;
+
+		std::mutex					mutex;
+		std::vector<IntList>		lists;
+		std::vector<std::thread>	threads;
+
+		// Lists built on worker threads are destroyed by the main thread
+		for (int t = 0; t < threadCount; t++)
+		{
+			threads.emplace_back([&mutex, &lists, t]()
+			{
+				for (int l = 0; l < listsPerThread; l++)
+				{
+					IntList intList;
+
+					for (int i = 0; i < 100; i++)
+						intList.push_back(t * 100 + i);
+
+					std::lock_guard<std::mutex> lock(mutex);
+					lists.push_back(std::move(intList));
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		long long sum = 0;
+
+		for (IntList& intList : lists)
+			for (int item : intList)
+				sum += item;
+
+		REQUIRE(lists.size() == threadCount * listsPerThread);
+		REQUIRE(sum == listsPerThread * (threadCount * 100LL * (threadCount * 100 - 1) / 2));
+
+		DO(lists.clear());
+	}
+
+	{
+		// Pools of different element types share the memory spy upstream
+		std::thread intThread([]()
+		{
+			my::list<int, ThreadCacheAllocator<int>> intList;
+
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < 500; i++)
+					intList.push_back(i);
+
+				intList.clear();
+				CThreadCachePool::TrimAll();
+			}
+		});
+
+		std::thread doubleThread([]()
+		{
+			my::list<double, ThreadCacheAllocator<double>> doubleList;
+
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < 500; i++)
+					doubleList.push_back(i);
+
+				doubleList.clear();
+				CThreadCachePool::TrimAll();
+			}
+		});
+
+		intThread.join();
+		doubleThread.join();
+	}
+
+	DO(CThreadCachePool::TrimAll());
+
+	g_memorySpy.CheckLeaks();
+}
+
+
+/* String */
+TEST_CASE("String", "[VectorList]")
+{
+	std::printf("\n=======Strings================\n");
+
+	{
+
+		std::printf("Sizeof String : %llu\n", sizeof(string));
+
+		{
+			DO(string s);
+			std::printf("Length of s : %llu\n", s.length());
+		}
+
+		{
+			DO(string s = "Moins de 16 car");
+			std::printf("Length of s : %llu\n", s.length());
+		}
+
+		{
+			DO(string s = "Plus de 16 car, 27 au total");
+			std::printf("Length of s : %llu\n", s.length());
+		}
+
+		{
+			DO(string s = "Plus de 32 car, 34 pour etre exact");
+			std::printf("Length of s : %llu\n", s.length());
+		}
+
+		{
+			DO(string s = "Plus de 48 car, 51 pour etre exact, bon ca suffit ?");
+			std::printf("Length of s : %llu\n", s.length());
+		}
+
+		{
+			DO(string s1 = "toto est vraiment une personne incroyable");
+			DO(string s2 = s1);
+			DO(s1[1] = 'a');
+			DO(s1[3] = 'a');
+			std::printf("s1 : %s\n", s1.c_str());
+			std::printf("s2 : %s\n", s2.c_str());
+			DO(s2 = s1);
+			DO(s2[3] = 'i');
+			std::printf("s1 : %s\n", s1.c_str());
+			std::printf("s2 : %s\n", s2.c_str());
+		}
+
+		DO(string s1 = "Bonjour");
+		DO(string s2 = " le monde !");
+		DO(string s3 = s1 + s2);
+		std::printf("s3 : %s\n", s3.c_str());
+
+		std::printf("\nDestroy string\n\n");
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Short strings are kept in place, up to 23 chars on x64 */
+TEST_CASE("String_SmallLayout", "[VectorList]")
+{
+	std::printf("\n=======String_SmallLayout================\n");
+
+	REQUIRE(sizeof(my::string) == 3 * sizeof(void*));
+
+	{
+		const size_t blockCount = g_memorySpy.BlockCount();
+		const size_t inlineSize = sizeof(my::string) - 1;
+
+		DO(my::string empty);
+		REQUIRE(empty.size() == 0);
+		REQUIRE(empty.empty());
+		REQUIRE(empty.capacity() == inlineSize);
+		REQUIRE(empty.c_str()[0] == '\0');
+
+		DO(my::string full = "Exactly twenty-three ch");
+		REQUIRE(full.size() == 23);
+		REQUIRE(full.size() == inlineSize);
+		REQUIRE(std::strcmp(full.c_str(), "Exactly twenty-three ch") == 0);
+		REQUIRE(g_memorySpy.BlockCount() == blockCount);
+
+		DO(my::string longer = "Exactly twenty-four char");
+		REQUIRE(longer.size() == 24);
+		REQUIRE(longer.capacity() > inlineSize);
+		REQUIRE(std::strcmp(longer.c_str(), "Exactly twenty-four char") == 0);
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1);
+
+		// A short value assigned to a long string keeps its block
+		const size_t longCapacity = longer.capacity();
+		DO(longer = "short");
+		REQUIRE(longer.size() == 5);
+		REQUIRE(longer.capacity() == longCapacity);
+		REQUIRE(std::strcmp(longer.c_str(), "short") == 0);
+
+		DO(longer = full + "!");
+		REQUIRE(longer.size() == 24);
+		REQUIRE(longer[23] == '!');
+
+		const char* longStr = longer.c_str();
+		DO(my::string moved = std::move(longer));
+		REQUIRE(moved.c_str() == longStr);
+		REQUIRE(longer.size() == 0);
+		REQUIRE(longer.c_str()[0] == '\0');
+
+		DO(my::string shortMoved = std::move(full));
+		REQUIRE(shortMoved.size() == 23);
+		REQUIRE(full.empty());
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1);
+
+		DO(shortMoved.clear());
+		REQUIRE(shortMoved.size() == 0);
+		REQUIRE(shortMoved.c_str()[0] == '\0');
+
+		DO(my::basic_string<char16_t> wide = u"Wide");
+		REQUIRE(wide.size() == 4);
+		REQUIRE(wide.capacity() == sizeof(my::string) / sizeof(char16_t) - 1);
+		REQUIRE(wide.c_str()[4] == u'\0');
+		REQUIRE(g_memorySpy.BlockCount() == blockCount + 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Test : append, push_back, +=, reserve, resize, shrink_to_fit */
+TEST_CASE("String_Append", "[VectorList]")
+{
+	std::printf("\n=======String_Append================\n");
+
+	{
+		DO(my::string str);
+
+		// The capacity grows geometrically, a few allocations for a thousand chars
+		const int firstId = CMemorySpy::s_curId;
+
+		for (size_t i = 0; i < 1000; i++)
+			str.push_back(static_cast<char>('a' + i % 26));
+
+		REQUIRE(str.size() == 1000);
+		REQUIRE(CMemorySpy::s_curId - firstId < 20);
+		REQUIRE(str[0] == 'a');
+		REQUIRE(str[999] == static_cast<char>('a' + 999 % 26));
+		REQUIRE(str.c_str()[1000] == '\0');
+
+		DO(str.resize(3));
+		REQUIRE(std::strcmp(str.c_str(), "abc") == 0);
+
+		DO(str.shrink_to_fit());
+		REQUIRE(str.capacity() == sizeof(my::string) - 1);
+		REQUIRE(std::strcmp(str.c_str(), "abc") == 0);
+
+		DO(str += "def");
+		DO(str += 'g');
+		DO(str.append(3, '!'));
+		REQUIRE(std::strcmp(str.c_str(), "abcdefg!!!") == 0);
+
+		DO(str.append(str));
+		DO(str.append(str.c_str() + 1, 2));
+		REQUIRE(std::strcmp(str.c_str(), "abcdefg!!!abcdefg!!!bc") == 0);
+
+		// Promoted to the heap with the appended part in one go
+		DO(str += my::string("0123456789"));
+		REQUIRE(str.size() == 32);
+		REQUIRE(std::strcmp(str.c_str(), "abcdefg!!!abcdefg!!!bc0123456789") == 0);
+
+		DO(str.reserve(100));
+		REQUIRE(str.capacity() >= 100);
+		REQUIRE(std::strcmp(str.c_str(), "abcdefg!!!abcdefg!!!bc0123456789") == 0);
+
+		const size_t capacity = str.capacity();
+		DO(str.resize(40, '?'));
+		REQUIRE(str.capacity() == capacity);
+		REQUIRE(str[39] == '?');
+		REQUIRE(str.c_str()[40] == '\0');
+
+		DO(str.shrink_to_fit());
+		REQUIRE(str.capacity() < capacity);
+		REQUIRE(str.size() == 40);
+		REQUIRE(str[31] == '9');
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Test : concat and chained operator+ */
+TEST_CASE("String_Concat", "[VectorList]")
+{
+	std::printf("\n=======String_Concat================\n");
+
+	{
+		DO(my::string level = "WARN");
+		DO(my::string message = "disk usage above ninety percent");
+		const char* module = "storage";
+
+		// One block for the result, whatever the number of pieces
+		const int firstId = CMemorySpy::s_curId;
+		DO(my::string line = my::concat(level, " [", module, "] ", message, '!'));
+		REQUIRE(CMemorySpy::s_curId - firstId == 1);
+		REQUIRE(std::strcmp(line.c_str(), "WARN [storage] disk usage above ninety percent!") == 0);
+
+		DO(my::string chained = level + " [" + module + "] " + message);
+		REQUIRE(std::strcmp(chained.c_str(), "WARN [storage] disk usage above ninety percent") == 0);
+
+		DO(my::string small = my::concat("a", 'b', my::string("c")));
+		REQUIRE(std::strcmp(small.c_str(), "abc") == 0);
+		REQUIRE(small.capacity() == sizeof(my::string) - 1);
+
+		// The left operand is left alone when it is not a temporary
+		REQUIRE(std::strcmp(level.c_str(), "WARN") == 0);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+// Terminators placed at every offset and length of a buffer, the vectorized scan must find each of them
+template <typename T>
+static void	checkStringLength()
+{
+	std::vector<T> buffer(256, static_cast<T>('x'));
+
+	for (size_t offset = 0; offset < 64; offset++)
+	{
+		for (size_t length = 0; length < 100; length++)
+		{
+			buffer[offset + length] = static_cast<T>(0);
+
+			REQUIRE(my::simd::stringLength(&buffer[offset]) == length);
+
+			buffer[offset + length] = static_cast<T>('x');
+		}
+	}
+}
+
+/* Test : stringLength and the length taking constructor and assign */
+TEST_CASE("String_Length", "[VectorList]")
+{
+	std::printf("\n=======String_Length================\n");
+
+	checkStringLength<char>();
+	checkStringLength<char16_t>();
+	checkStringLength<char32_t>();
+	checkStringLength<wchar_t>();
+
+	REQUIRE(my::string::stringLength(nullptr) == 0);
+	REQUIRE(my::string::stringLength("Hello World!") == 12);
+
+	{
+		// A known length is taken as is, even past a null character
+		DO(my::string str("abc\0def", 7));
+		REQUIRE(str.size() == 7);
+		REQUIRE(str[6] == 'f');
+
+		DO(str.assign("Hello World!", 5));
+		REQUIRE(std::strcmp(str.c_str(), "Hello") == 0);
+
+		DO(str.assign("A string too long to be kept in place"));
+		REQUIRE(str.size() == 37);
+
+		DO(str.assign(str.c_str() + 2, 6));
+		REQUIRE(std::strcmp(str.c_str(), "string") == 0);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Test : find, rfind, find_first_of, find_last_not_of, starts_with, ends_with, contains */
+TEST_CASE("String_Find", "[VectorList]")
+{
+	std::printf("\n=======String_Find================\n");
+
+	{
+		DO(my::string str = "GET /index.html HTTP/1.1   ");
+
+		REQUIRE(str.find("/index") == 4);
+		REQUIRE(str.find('/') == 4);
+		REQUIRE(str.find('/', 5) == 20);
+		REQUIRE(str.find("POST") == my::string::npos);
+		REQUIRE(str.find("") == 0);
+		REQUIRE(str.find("", str.size()) == str.size());
+		REQUIRE(str.find("GET", 100) == my::string::npos);
+
+		REQUIRE(str.rfind('/') == 20);
+		REQUIRE(str.rfind('/', 19) == 4);
+		REQUIRE(str.rfind("HTTP") == 16);
+		REQUIRE(str.rfind("GET", 0) == 0);
+		REQUIRE(str.rfind("GET /index.html HTTP/1.1   and more") == my::string::npos);
+
+		REQUIRE(str.find_first_of(" /") == 3);
+		REQUIRE(str.find_first_of("./", 5) == 10);
+		REQUIRE(str.find_first_of("qwz") == my::string::npos);
+
+		REQUIRE(str.find_last_not_of(" ") == 23);
+		REQUIRE(str.find_last_not_of(" 1.", 22) == 20);
+		REQUIRE(my::string("   ").find_last_not_of(" ") == my::string::npos);
+
+		REQUIRE(str.starts_with("GET "));
+		REQUIRE(str.starts_with('G'));
+		REQUIRE_FALSE(str.starts_with("POST"));
+		REQUIRE(str.ends_with("1.1   "));
+		REQUIRE(str.ends_with(' '));
+		REQUIRE_FALSE(str.ends_with("1.1"));
+		REQUIRE(str.contains("HTTP/"));
+		REQUIRE(str.contains('.'));
+		REQUIRE_FALSE(str.contains("https"));
+	}
+
+	{
+		// Every needle of a small alphabet text, short ones take the vectorized path and long ones Horspool
+		std::string reference;
+
+		for (size_t i = 0; i < 600; i++)
+			reference += static_cast<char>('a' + (i * 7 + i / 13) % 3);
+
+		const my::string str(reference.c_str(), reference.size());
+		bool allFound = true;
+
+		for (size_t needleSize = 1; needleSize < 48; needleSize++)
+		{
+			for (size_t start = 0; start + needleSize <= reference.size(); start += 37)
+			{
+				const std::string needle = reference.substr(start, needleSize);
+				const my::string myNeedle(needle.c_str(), needle.size());
+
+				for (size_t pos = 0; pos < reference.size(); pos += 101)
+				{
+					allFound &= str.find(myNeedle, pos) == reference.find(needle, pos);
+					allFound &= str.rfind(myNeedle, pos) == reference.rfind(needle, pos);
+				}
+			}
+		}
+
+		REQUIRE(allFound);
+		REQUIRE(str.find(my::string("abcabcabcabcabcabcabcabcabcabcabcabcabcabc")) == my::string::npos);
+	}
+
+	{
+		// Characters sharing a low byte must not be mistaken for each other
+		const char16_t needle[] = u"\u0161\u0162\u0163 a long wide needle, long enough for Horspool";
+		my::basic_string<char16_t> wide = u"a";
+
+		for (int i = 0; i < 20; i++)
+			wide += u"ab\u0161\u0162 ";
+
+		const size_t expected = wide.size();
+		wide += needle;
+
+		REQUIRE(wide.find(needle) == expected);
+		REQUIRE(wide.find(u"ab\u0161") == 1);
+		REQUIRE(wide.find(u"aba") == my::basic_string<char16_t>::npos);
+		REQUIRE(wide.find_first_of(u"\u0162") == 4);
+		REQUIRE(wide.find_first_of(u"b") == 2);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+/* Test : string_view, substr_view and split */
+TEST_CASE("String_View", "[VectorList]")
+{
+	std::printf("\n=======String_View================\n");
+
+	{
+		DO(my::string request = "GET /users/42/profile?fields=name,email HTTP/1.1");
+
+		// Nothing below allocates
+		const int firstId = CMemorySpy::s_curId;
+
+		const my::string_view view = request;
+		REQUIRE(view.size() == request.size());
+		REQUIRE(view.data() == request.c_str());
+
+		const my::string_view path = request.substr_view(4, 35);
+		REQUIRE(path == "/users/42/profile?fields=name,email");
+		REQUIRE(path.starts_with('/'));
+		REQUIRE(path.ends_with("email"));
+		REQUIRE(path.find('?') == 17);
+		REQUIRE(path.rfind('/') == 9);
+		REQUIRE(path.find_first_of("?=") == 17);
+		REQUIRE(path.find_last_not_of("lmai") == 30);
+		REQUIRE(path.contains("fields"));
+		REQUIRE(path.substr(18) == "fields=name,email");
+		REQUIRE(path.substr(18, 6) < path.substr(25));
+		REQUIRE(path.compare("/users") > 0);
+		REQUIRE(my::string_view("abc").compare("abd") < 0);
+		REQUIRE(my::string_view("abc") != "ab");
+
+		const char* const expectedParts[] = { "GET", "/users/42/profile?fields=name,email", "HTTP/1.1" };
+		size_t count = 0;
+
+		for (const my::string_view part : view.split(' '))
+		{
+			REQUIRE(part == expectedParts[count]);
+			count++;
+		}
+
+		REQUIRE(count == 3);
+
+		count = 0;
+
+		for (const my::string_view segment : path.substr(1, path.find('?') - 1).split('/'))
+			count += segment.size();
+
+		REQUIRE(count == 14);
+		REQUIRE(CMemorySpy::s_curId == firstId);
+		REQUIRE_THROWS_AS(request.substr_view(request.size() + 1), std::out_of_range);
+	}
+
+	{
+		// n delimiters give n + 1 parts, empty ones included
+		const my::string_view csv = "a,,b,";
+		std::vector<std::string> parts;
+
+		for (my::string_view::split_range::iterator it = csv.split(',').begin(); it != csv.split(',').end(); ++it)
+			parts.push_back(std::string(it->data(), it->size()));
+
+		REQUIRE(parts == std::vector<std::string>({ "a", "", "b", "" }));
+
+		parts.clear();
+
+		for (const my::string_view line : my::string_view("HTTP/1.1 200 OK\r\nHost: x\r\n\r\nbody").split("\r\n"))
+			parts.push_back(std::string(line.data(), line.size()));
+
+		REQUIRE(parts == std::vector<std::string>({ "HTTP/1.1 200 OK", "Host: x", "", "body" }));
+
+		// An empty view is a single empty part
+		size_t count = 0;
+
+		for (const my::string_view part : my::string_view().split(','))
+			count += 1 + part.size();
+
+		REQUIRE(count == 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+#if STRING_COPY_ON_WRITE
+/* Test : heap strings share their block until one copy is written to */
+TEST_CASE("String_CopyOnWrite", "[VectorList]")
+{
+	std::printf("\n=======String_CopyOnWrite================\n");
+
+	{
+		DO(my::string payload = "A payload long enough to be stored on the heap, passed around by value");
+		const char* block = payload.c_str();
+
+		const int firstId = CMemorySpy::s_curId;
+
+		DO(my::string copy = payload);
+		DO(my::string assigned);
+		DO(assigned = copy);
+		REQUIRE(copy.c_str() == block);
+		REQUIRE(assigned.c_str() == block);
+
+		// Reading keeps the block shared
+		const my::string& constCopy = copy;
+		REQUIRE(constCopy[0] == 'A');
+		REQUIRE(*constCopy.begin() == 'A');
+		REQUIRE(copy.find("heap") == 42);
+		REQUIRE(CMemorySpy::s_curId == firstId);
+
+		DO(copy[0] = 'a');
+		REQUIRE(copy.c_str() != block);
+		REQUIRE(copy.c_str()[0] == 'a');
+		REQUIRE(payload.c_str()[0] == 'A');
+		REQUIRE(assigned.c_str() == block);
+
+		DO(*assigned.begin() = 'B');
+		REQUIRE(assigned.c_str() != block);
+		REQUIRE(payload.c_str() == block);
+		REQUIRE(std::strcmp(payload.c_str(), "A payload long enough to be stored on the heap, passed around by value") == 0);
+
+		DO(my::string appended = payload);
+		DO(appended += "!");
+		REQUIRE(appended.ends_with("value!"));
+		REQUIRE(payload.ends_with("value"));
+
+		DO(my::string cleared = payload);
+		DO(cleared.clear());
+		REQUIRE(cleared.empty());
+		REQUIRE(payload.size() == 70);
+
+		DO(my::string reassigned = payload);
+		DO(reassigned = "short");
+		REQUIRE(std::strcmp(reassigned.c_str(), "short") == 0);
+		REQUIRE(payload.c_str() == block);
+
+		// A string assigned a part of its own shared block
+		DO(my::string self = payload);
+		DO(self.assign(self.c_str() + 2, 7));
+		REQUIRE(std::strcmp(self.c_str(), "payload") == 0);
+
+		// A reference handed out before the copy still writes to the original only
+		DO(my::string written = payload);
+		DO(char& first = written[0]);
+		DO(my::string afterReference = written);
+		DO(first = 'X');
+		REQUIRE(afterReference.c_str()[0] == 'A');
+		REQUIRE(written[0] == 'X');
+		REQUIRE(afterReference.c_str() != written.c_str());
+
+		DO(char* str = written.data());
+		DO(my::string afterPointer);
+		DO(afterPointer = written);
+		DO(str[1] = 'Y');
+		REQUIRE(afterPointer.c_str()[1] == ' ');
+		REQUIRE(written.c_str()[1] == 'Y');
+
+		// Only the block handed out stays unshareable, the deep copies are shared again
+		DO(my::string shared = afterReference);
+		REQUIRE(shared.c_str() == afterReference.c_str());
+
+		// Short strings are still copied
+		DO(my::string small = "short");
+		DO(my::string smallCopy = small);
+		REQUIRE(smallCopy.c_str() != small.c_str());
+	}
+
+	{
+		// Copies made and dropped from several threads, only the reference count changes.
+		// The memory spy is not thread safe, nothing is allocated in the threads.
+		my::string shared = "A string shared by every thread, long enough to live on the heap";
+		const char* block = shared.c_str();
+		std::vector<std::thread> threads;
+
+		for (int t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&shared]()
+			{
+				for (int i = 0; i < 1000; i++)
+				{
+					const my::string copy = shared;
+					const my::string other = copy;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		// Back to a single owner, writing does not copy
+		DO(shared[0] = 'a');
+		REQUIRE(shared.c_str() == block);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+#endif
+
+TEST_CASE("String_Hash", "[VectorList]")
+{
+	std::printf("\n=======String_Hash================\n");
+
+	{
+		DO(my::string small = "key");
+		DO(my::string large = "A key long enough to be stored on the heap, hashed more than once");
+		const size_t largeHash = my::string_view(large.c_str(), large.size()).hash();
+
+		REQUIRE(small.hash() == my::string_view("key").hash());
+		REQUIRE(large.hash() == largeHash);
+		REQUIRE(large.hash() == largeHash);
+		REQUIRE(std::hash<my::string>()(large) == std::hash<my::string_view>()(large));
+
+		// Every size around the 4, 16 and 48 bytes steps, and a change in any of the characters
+		const my::string_view text = "The quick brown fox jumps over the lazy dog, then runs around the field a few more times";
+		std::unordered_set<size_t> hashes;
+
+		for (size_t size = 0; size <= text.size(); size++)
+		{
+			hashes.insert(text.substr(0, size).hash());
+
+			char changed[128];
+			std::copy(text.begin(), text.end(), changed);
+
+			for (size_t i = 0; i < size; i++)
+			{
+				changed[i] ^= 1;
+				REQUIRE(my::string_view(changed, size).hash() != text.substr(0, size).hash());
+				changed[i] ^= 1;
+			}
+		}
+
+		REQUIRE(hashes.size() == text.size() + 1);
+
+		// A copy shares the block, and its hash, until written to
+		DO(my::string copy = large);
+		REQUIRE(copy == large);
+		REQUIRE(copy.hash() == largeHash);
+
+		DO(copy[0] = 'a');
+		REQUIRE(copy != large);
+		REQUIRE(copy.hash() != largeHash);
+		REQUIRE(copy.hash() == my::string_view(copy.c_str(), copy.size()).hash());
+		REQUIRE(large.hash() == largeHash);
+
+		// Changes in place forget the hash as well
+		DO(large += '!');
+		REQUIRE(large.hash() != largeHash);
+		DO(large.resize(large.size() - 1));
+		REQUIRE(large.hash() == largeHash);
+
+		DO(copy.assign(large));
+		REQUIRE(copy == large);
+		REQUIRE(copy.hash() == largeHash);
+		REQUIRE(copy != my::string("A key long enough to be stored on the heap, hashed more than twice"));
+	}
+
+	{
+		// Written through a pointer taken before the hash was asked for, nothing is cached
+		DO(my::string written = "A key long enough to be stored on the heap, written through a pointer");
+		DO(const my::string same = "Z key long enough to be stored on the heap, written through a pointer");
+		DO(char* str = written.data());
+		REQUIRE(written.hash() != same.hash());
+
+		DO(str[0] = 'Z');
+		REQUIRE(written.hash() == same.hash());
+		REQUIRE(written == same);
+		REQUIRE(same == written);
+	}
+
+	{
+		// Keys of a standard container, no conversion to std::string
+		std::unordered_map<my::string, int> counts;
+
+		for (const my::string_view word : my::string_view("the cat and the dog and the bird").split(' '))
+			counts[my::string(word.data(), word.size())]++;
+
+		REQUIRE(counts.size() == 5);
+		REQUIRE(counts[my::string("the")] == 3);
+		REQUIRE(counts[my::string("and")] == 2);
+		REQUIRE(counts[my::string("bird")] == 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+TEST_CASE("String_InternTable", "[VectorList]")
+{
+	std::printf("\n=======String_InternTable================\n");
+
+	{
+		DO(my::intern_table table);
+
+		const size_t firstDedup = g_memorySpy.DedupBytes();
+
+		DO(my::interned_string<> hello = table.intern("hello"));
+		DO(my::interned_string<> world = table.intern(my::string_view("world")));
+		REQUIRE(hello);
+		REQUIRE(hello != world);
+		REQUIRE(hello.id() != world.id());
+		REQUIRE(std::strcmp(hello.c_str(), "hello") == 0);
+		REQUIRE(world.size() == 5);
+		REQUIRE(table.size() == 2);
+		REQUIRE(g_memorySpy.DedupBytes() == firstDedup);
+
+		// Equal contents from any source give back the same handle, nothing is allocated
+		const int firstId = CMemorySpy::s_curId;
+
+		DO(my::string owned = "hello");
+		DO(my::interned_string<> again = table.intern(owned));
+		REQUIRE(again == hello);
+		REQUIRE(again.id() == hello.id());
+		REQUIRE(again.hash() == hello.hash());
+		REQUIRE(again.c_str() == hello.c_str());
+		REQUIRE(table.intern("world") == world);
+		REQUIRE(CMemorySpy::s_curId == firstId);
+		REQUIRE(table.size() == 2);
+		REQUIRE(table.saved_bytes() == 12);
+		REQUIRE(g_memorySpy.DedupBytes() - firstDedup == 12);
+
+		// find never interns
+		REQUIRE(table.find("hello") == hello);
+		REQUIRE(!table.find("absent"));
+		REQUIRE(table.size() == 2);
+
+		// The empty string is a string like any other
+		DO(my::interned_string<> empty = table.intern(""));
+		REQUIRE(empty);
+		REQUIRE(empty.size() == 0);
+		REQUIRE(table.intern(my::string_view()) == empty);
+
+		const my::string_view view = hello;
+		REQUIRE(view == "hello");
+
+		std::hash<my::interned_string<>> hasher;
+		REQUIRE(hasher(again) == hasher(hello));
+
+		g_memorySpy.ReportDedup();
+	}
+
+	{
+		// Every thread interns the same keys, each key ends up interned once.
+		// The table serializes its allocations, the threads themselves only use std::allocator.
+		my::intern_table table;
+		std::vector<std::thread> threads;
+		std::vector<std::vector<my::interned_string<>>> results(4);
+
+		for (int t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&table, &results, t]()
+			{
+				char key[32];
+
+				for (int i = 0; i < 100; i++)
+				{
+					const int length = std::snprintf(key, sizeof(key), "key number %d", (i + t * 25) % 100);
+					results[t].push_back(table.intern(my::string_view(key, length)));
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		REQUIRE(table.size() == 100);
+
+		for (int t = 1; t < 4; t++)
+		{
+			for (int i = 0; i < 100; i++)
+				REQUIRE(results[t][i] == results[0][(i + t * 25) % 100]);
+		}
+
+		REQUIRE(table.find("key number 42") == results[0][42]);
+		REQUIRE(table.saved_bytes() == 300 * 14 - 30);
+	}
+
+	{
+		my::basic_intern_table<char, FailingAllocator<char>> table;
+
+		// The entry is allocated, the first slots of the index are not
+		FailingAllocation::s_allocationsLeft = 1;
+		REQUIRE_THROWS_AS(table.intern("hello"), std::bad_alloc);
+		FailingAllocation::s_allocationsLeft = -1;
+
+		REQUIRE(table.size() == 0);
+		REQUIRE(!table.find("hello"));
+
+		REQUIRE(table.intern("hello"));
+		REQUIRE(table.size() == 1);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+TEST_CASE("String_Rope", "[VectorList]")
+{
+	std::printf("\n=======String_Rope================\n");
+
+	{
+		// 5000 characters, cut into leaves of at most ROPE_LEAF_SIZE
+		std::string expected;
+
+		for (int i = 0; expected.size() < 5000; i++)
+			expected += "line " + std::to_string(i) + " of a document too large to edit as a single string\n";
+
+		expected.resize(5000);
+
+		DO(my::rope text(my::string_view(expected.c_str(), expected.size())));
+		REQUIRE(text.size() == 5000);
+		REQUIRE(text[0] == 'l');
+		REQUIRE(text[4999] == expected[4999]);
+		REQUIRE_THROWS_AS(text[5000], std::out_of_range);
+
+		size_t leafCount = 0;
+		std::string joined;
+
+		for (const my::string_view leaf : text.leaves())
+		{
+			REQUIRE(leaf.size() <= ROPE_LEAF_SIZE);
+			joined.append(leaf.data(), leaf.size());
+			leafCount++;
+		}
+
+		REQUIRE(leafCount == 10);
+		REQUIRE(joined == expected);
+
+		// Edits spread over the whole text, checked against std::string
+		for (size_t i = 0; i < 300; i++)
+		{
+			const size_t pos = i * 7919 % (expected.size() + 1);
+
+			if (i % 3 == 2)
+			{
+				text.erase(pos, i % 40);
+				expected.erase(pos, i % 40);
+			}
+			else
+			{
+				const char* word = i % 2 == 0 ? "inserted " : "x";
+				text.insert(pos, word);
+				expected.insert(pos, word);
+			}
+		}
+
+		my::string flat = text.flatten();
+		REQUIRE(flat.size() == expected.size());
+		REQUIRE(std::memcmp(flat.c_str(), expected.c_str(), expected.size()) == 0);
+
+		for (size_t i = 0; i < expected.size(); i += 97)
+			REQUIRE(text[i] == expected[i]);
+
+		// Copies and substrings share the tree, only the nodes on the edited path are new
+		const int firstId = CMemorySpy::s_curId;
+
+		DO(my::rope copy = text);
+		REQUIRE(CMemorySpy::s_curId == firstId);
+
+		DO(copy.insert(100, "copy only "));
+		REQUIRE(copy.size() == text.size() + 10);
+		REQUIRE(CMemorySpy::s_curId - firstId < 40);
+		REQUIRE(text.flatten() == flat);
+
+		DO(my::rope middle = text.substr(1000, 2000));
+		REQUIRE(middle.size() == 2000);
+		REQUIRE(middle.flatten() == my::string(expected.c_str() + 1000, 2000));
+
+		// A rope inserted in itself
+		DO(middle.insert(500, middle));
+		REQUIRE(middle.size() == 4000);
+		REQUIRE(middle[500] == expected[1000]);
+		REQUIRE(middle[2500] == expected[1500]);
+
+		DO(text.erase(0));
+		REQUIRE(text.empty());
+		REQUIRE(text.leaves().begin() == text.leaves().end());
+		REQUIRE(copy.size() == expected.size() + 10);
+
+		DO(text.append("tail"));
+		DO(text.append(my::rope("end")));
+		REQUIRE(text.flatten() == my::string("tailend"));
+		REQUIRE_THROWS_AS(text.insert(8, "out"), std::out_of_range);
+		REQUIRE_THROWS_AS(text.substr(8), std::out_of_range);
+	}
+
+	{
+		// One character at a time, adjacent small leaves are merged
+		my::rope typed;
+
+		for (int i = 0; i < 2000; i++)
+			typed.insert(typed.size() / 2, i % 2 == 0 ? "a" : "b");
+
+		size_t leafCount = 0;
+
+		for (my::rope::leaf_range::const_iterator it = typed.leaves().begin(); it != typed.leaves().end(); ++it)
+			leafCount++;
+
+		REQUIRE(typed.size() == 2000);
+		REQUIRE(leafCount < 2000 / 8);
+	}
+
+	g_memorySpy.CheckLeaks();
+}
+
+
 /* Test : begin, end, string iterator operators */
 TEST_CASE("String_Iterators", "[VectorList]")
 {
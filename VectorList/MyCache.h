@@ -0,0 +1,820 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "MyIntrusiveList.h"
+#include "SpyAllocator.h"
+
+namespace my
+{
+	#define CACHE_POOL_BLOCK_SIZE 64
+	#define CACHE_INDEX_MIN_SIZE 16
+
+	enum class cache_capacity
+	{
+		entries,
+		bytes
+	};
+
+	// Default cost of an entry when the capacity is given in bytes
+	template <typename K, typename V>
+	struct cache_entry_size
+	{
+		size_t	operator()(const K& key, const V& value) const;
+	};
+
+	namespace detail
+	{
+		// Hands out uninitialized nodes carved from blocks of CACHE_POOL_BLOCK_SIZE nodes.
+		// Freed nodes are chained through their own storage and reused first.
+		template <typename Node, class Allocator>
+		class cache_node_pool
+		{
+		public:
+			cache_node_pool();
+			cache_node_pool(const cache_node_pool& other) = delete;
+			~cache_node_pool();
+
+			cache_node_pool&	operator=(const cache_node_pool& other) = delete;
+
+			Node*	allocate();
+			void	deallocate(Node* node);
+
+		private:
+			class Block
+			{
+				friend	cache_node_pool;
+			public:
+				Block(Node* nodes, Block* next);
+
+			private:
+				Node*	m_nodes;
+				Block*	m_next;
+			};
+
+			typedef typename Allocator::template rebind<Node>::other NodeAllocator;
+			typedef typename Allocator::template rebind<Block>::other BlockAllocator;
+
+			Block*	m_blocks;
+			Node*	m_free;
+			size_t	m_used; // Nodes handed out from the newest block
+		};
+
+		// Open addressing index with linear probing over entry pointers.
+		// Entries keep their hash in m_hash so growing the table never hashes a key again.
+		template <typename Entry, typename K, class Hash, class Allocator>
+		class cache_index
+		{
+		public:
+			cache_index();
+			cache_index(const cache_index& other) = delete;
+			~cache_index();
+
+			cache_index&	operator=(const cache_index& other) = delete;
+
+			Entry*	find(const K& key, size_t hash) const;
+			void	insert(Entry* entry);
+			void	erase(Entry* entry);
+			void	clear();
+
+		private:
+			typedef typename Allocator::template rebind<Entry*>::other SlotAllocator;
+
+			Entry**	m_slots;
+			size_t	m_slotCount;
+			size_t	m_used; // Entries and tombstones
+
+			static Entry*	tombstone();
+			void			rehash(size_t slotCount);
+		};
+	}
+
+	// A cache evicting the least recently used entry once the capacity is reached.
+	template <typename K, typename V, class Hash = std::hash<K>, class Sizer = cache_entry_size<K, V>,
+		class Allocator = SpyAllocator<V>>
+	class lru_cache
+	{
+	public:
+		typedef std::function<void(const K&, V&)> eviction_callback;
+
+		explicit lru_cache(size_t capacity, cache_capacity unit = cache_capacity::entries);
+		lru_cache(const lru_cache& other) = delete;
+		~lru_cache();
+
+		lru_cache&	operator=(const lru_cache& other) = delete;
+
+		V*			find(const K& key);
+		bool		contains(const K& key) const;
+
+		bool		insert(const K& key, const V& value);
+		bool		erase(const K& key);
+		void		clear();
+
+		size_t		size() const;
+		size_t		used() const;
+		size_t		capacity() const;
+
+		size_t		hits() const;
+		size_t		misses() const;
+
+		void		set_eviction_callback(eviction_callback callback);
+
+	private:
+		struct Entry
+		{
+			Entry(const K& key, const V& value, size_t hash, size_t cost);
+
+			K							m_key;
+			V							m_value;
+			size_t						m_hash;
+			size_t						m_cost;
+			intrusive_list_hook<Entry>	m_hook;
+		};
+
+		typedef intrusive_list<Entry, &Entry::m_hook>					EntryList;
+		typedef detail::cache_node_pool<Entry, Allocator>				EntryPool;
+		typedef detail::cache_index<Entry, K, Hash, Allocator>			EntryIndex;
+
+		EntryList			m_entries; // Most recently used first
+		EntryPool			m_pool;
+		EntryIndex			m_index;
+		eviction_callback	m_onEvict;
+		cache_capacity		m_unit;
+		size_t				m_capacity;
+		size_t				m_used;
+		size_t				m_hits;
+		size_t				m_misses;
+
+		size_t	entryCost(const K& key, const V& value) const;
+		void	removeEntry(Entry* entry);
+	};
+
+	// A cache evicting the least frequently used entry once the capacity is reached,
+	// the least recently used one among them on ties.
+	// Entries sharing a use count sit in the same bucket, so a hit moves an entry in O(1).
+	template <typename K, typename V, class Hash = std::hash<K>, class Sizer = cache_entry_size<K, V>,
+		class Allocator = SpyAllocator<V>>
+	class lfu_cache
+	{
+	public:
+		typedef std::function<void(const K&, V&)> eviction_callback;
+
+		explicit lfu_cache(size_t capacity, cache_capacity unit = cache_capacity::entries);
+		lfu_cache(const lfu_cache& other) = delete;
+		~lfu_cache();
+
+		lfu_cache&	operator=(const lfu_cache& other) = delete;
+
+		V*			find(const K& key);
+		bool		contains(const K& key) const;
+
+		bool		insert(const K& key, const V& value);
+		bool		erase(const K& key);
+		void		clear();
+
+		size_t		size() const;
+		size_t		used() const;
+		size_t		capacity() const;
+
+		size_t		hits() const;
+		size_t		misses() const;
+
+		size_t		frequency(const K& key) const;
+
+		void		set_eviction_callback(eviction_callback callback);
+
+	private:
+		struct Bucket;
+
+		struct Entry
+		{
+			Entry(const K& key, const V& value, size_t hash, size_t cost);
+
+			K							m_key;
+			V							m_value;
+			size_t						m_hash;
+			size_t						m_cost;
+			Bucket*						m_bucket;
+			intrusive_list_hook<Entry>	m_hook;
+		};
+
+		typedef intrusive_list<Entry, &Entry::m_hook> EntryList;
+
+		struct Bucket
+		{
+			explicit Bucket(size_t frequency);
+
+			size_t						m_frequency;
+			EntryList					m_entries; // Most recently used first
+			intrusive_list_hook<Bucket>	m_hook;
+		};
+
+		typedef intrusive_list<Bucket, &Bucket::m_hook>				BucketList;
+		typedef detail::cache_node_pool<Entry, Allocator>			EntryPool;
+		typedef detail::cache_node_pool<Bucket, Allocator>			BucketPool;
+		typedef detail::cache_index<Entry, K, Hash, Allocator>		EntryIndex;
+
+		BucketList			m_buckets; // Lowest frequency first
+		EntryPool			m_entryPool;
+		BucketPool			m_bucketPool;
+		EntryIndex			m_index;
+		eviction_callback	m_onEvict;
+		cache_capacity		m_unit;
+		size_t				m_capacity;
+		size_t				m_size;
+		size_t				m_used;
+		size_t				m_hits;
+		size_t				m_misses;
+
+		size_t	entryCost(const K& key, const V& value) const;
+		void	touch(Entry* entry);
+		void	linkEntry(Entry* entry, typename BucketList::iterator next, size_t frequency);
+		void	unlinkEntry(Entry* entry);
+		void	removeEntry(Entry* entry);
+	};
+
+	template <typename K, typename V>
+	size_t cache_entry_size<K, V>::operator()(const K&, const V&) const
+	{
+		return sizeof(K) + sizeof(V);
+	}
+
+	template <typename Node, class Allocator>
+	detail::cache_node_pool<Node, Allocator>::Block::Block(Node* nodes, Block* next) : m_nodes(nodes), m_next(next)
+	{
+	}
+
+	template <typename Node, class Allocator>
+	detail::cache_node_pool<Node, Allocator>::cache_node_pool() :
+		m_blocks(nullptr), m_free(nullptr), m_used(CACHE_POOL_BLOCK_SIZE)
+	{
+	}
+
+	template <typename Node, class Allocator>
+	detail::cache_node_pool<Node, Allocator>::~cache_node_pool()
+	{
+		while (m_blocks)
+		{
+			Block* next = m_blocks->m_next;
+
+			NodeAllocator().deallocate(m_blocks->m_nodes, CACHE_POOL_BLOCK_SIZE);
+
+			m_blocks->~Block();
+			BlockAllocator().deallocate(m_blocks, 1);
+
+			m_blocks = next;
+		}
+	}
+
+	template <typename Node, class Allocator>
+	Node* detail::cache_node_pool<Node, Allocator>::allocate()
+	{
+		if (m_free != nullptr)
+		{
+			Node* node = m_free;
+			m_free = *reinterpret_cast<Node**>(node);
+			return node;
+		}
+
+		if (m_used == CACHE_POOL_BLOCK_SIZE)
+		{
+			Block* block = BlockAllocator().allocate(1);
+			new (block) Block(NodeAllocator().allocate(CACHE_POOL_BLOCK_SIZE), m_blocks);
+
+			m_blocks = block;
+			m_used = 0;
+		}
+
+		return &m_blocks->m_nodes[m_used++];
+	}
+
+	template <typename Node, class Allocator>
+	void detail::cache_node_pool<Node, Allocator>::deallocate(Node* node)
+	{
+		static_assert(sizeof(Node) >= sizeof(Node*), "Pooled nodes must be able to hold the free chain link");
+
+		*reinterpret_cast<Node**>(node) = m_free;
+		m_free = node;
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	detail::cache_index<Entry, K, Hash, Allocator>::cache_index() : m_slots(nullptr), m_slotCount(0), m_used(0)
+	{
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	detail::cache_index<Entry, K, Hash, Allocator>::~cache_index()
+	{
+		if (m_slots != nullptr)
+			SlotAllocator().deallocate(m_slots, m_slotCount);
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	Entry* detail::cache_index<Entry, K, Hash, Allocator>::find(const K& key, const size_t hash) const
+	{
+		if (m_slotCount == 0)
+			return nullptr;
+
+		const size_t mask = m_slotCount - 1;
+
+		for (size_t i = hash & mask;; i = (i + 1) & mask)
+		{
+			Entry* entry = m_slots[i];
+
+			if (entry == nullptr)
+				return nullptr;
+
+			if (entry != tombstone() && entry->m_hash == hash && entry->m_key == key)
+				return entry;
+		}
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	void detail::cache_index<Entry, K, Hash, Allocator>::insert(Entry* entry)
+	{
+		// Keep at least half of the slots empty for short probe sequences
+		if ((m_used + 1) * 2 > m_slotCount)
+			rehash(m_slotCount == 0 ? CACHE_INDEX_MIN_SIZE : m_slotCount * 2);
+
+		const size_t mask = m_slotCount - 1;
+
+		size_t i = entry->m_hash & mask;
+
+		while (m_slots[i] != nullptr && m_slots[i] != tombstone())
+			i = (i + 1) & mask;
+
+		if (m_slots[i] == nullptr)
+			m_used++;
+
+		m_slots[i] = entry;
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	void detail::cache_index<Entry, K, Hash, Allocator>::erase(Entry* entry)
+	{
+		const size_t mask = m_slotCount - 1;
+
+		size_t i = entry->m_hash & mask;
+
+		while (m_slots[i] != entry)
+			i = (i + 1) & mask;
+
+		// Probe sequences going through this slot must keep going
+		m_slots[i] = tombstone();
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	void detail::cache_index<Entry, K, Hash, Allocator>::clear()
+	{
+		for (size_t i = 0; i < m_slotCount; i++)
+			m_slots[i] = nullptr;
+
+		m_used = 0;
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	Entry* detail::cache_index<Entry, K, Hash, Allocator>::tombstone()
+	{
+		return reinterpret_cast<Entry*>(uintptr_t(1));
+	}
+
+	template <typename Entry, typename K, class Hash, class Allocator>
+	void detail::cache_index<Entry, K, Hash, Allocator>::rehash(size_t slotCount)
+	{
+		size_t liveCount = 0;
+
+		for (size_t i = 0; i < m_slotCount; i++)
+			if (m_slots[i] != nullptr && m_slots[i] != tombstone())
+				liveCount++;
+
+		// Dropping the tombstones might be enough to make room
+		while (slotCount > CACHE_INDEX_MIN_SIZE && (liveCount + 1) * 4 <= slotCount)
+			slotCount /= 2;
+
+		Entry** slots = SlotAllocator().allocate(slotCount);
+
+		for (size_t i = 0; i < slotCount; i++)
+			slots[i] = nullptr;
+
+		const size_t mask = slotCount - 1;
+
+		for (size_t i = 0; i < m_slotCount; i++)
+		{
+			Entry* entry = m_slots[i];
+
+			if (entry == nullptr || entry == tombstone())
+				continue;
+
+			size_t slot = entry->m_hash & mask;
+
+			while (slots[slot] != nullptr)
+				slot = (slot + 1) & mask;
+
+			slots[slot] = entry;
+		}
+
+		if (m_slots != nullptr)
+			SlotAllocator().deallocate(m_slots, m_slotCount);
+
+		m_slots = slots;
+		m_slotCount = slotCount;
+		m_used = liveCount;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lru_cache<K, V, Hash, Sizer, Allocator>::Entry::Entry(const K& key, const V& value, const size_t hash,
+		const size_t cost) : m_key(key), m_value(value), m_hash(hash), m_cost(cost)
+	{
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lru_cache<K, V, Hash, Sizer, Allocator>::lru_cache(const size_t capacity, const cache_capacity unit) :
+		m_unit(unit), m_capacity(capacity), m_used(0), m_hits(0), m_misses(0)
+	{
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lru_cache<K, V, Hash, Sizer, Allocator>::~lru_cache()
+	{
+		clear();
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	V* lru_cache<K, V, Hash, Sizer, Allocator>::find(const K& key)
+	{
+		Entry* entry = m_index.find(key, Hash()(key));
+
+		if (entry == nullptr)
+		{
+			m_misses++;
+			return nullptr;
+		}
+
+		m_hits++;
+		m_entries.splice(m_entries.begin(), m_entries, typename EntryList::iterator(entry));
+
+		return &entry->m_value;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lru_cache<K, V, Hash, Sizer, Allocator>::contains(const K& key) const
+	{
+		return m_index.find(key, Hash()(key)) != nullptr;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lru_cache<K, V, Hash, Sizer, Allocator>::insert(const K& key, const V& value)
+	{
+		const size_t hash = Hash()(key);
+		const size_t cost = entryCost(key, value);
+
+		if (cost > m_capacity)
+			return false;
+
+		Entry* entry = m_index.find(key, hash);
+
+		if (entry != nullptr)
+			removeEntry(entry);
+
+		while (m_used + cost > m_capacity)
+		{
+			Entry* oldest = &m_entries.back();
+
+			if (m_onEvict)
+				m_onEvict(oldest->m_key, oldest->m_value);
+
+			removeEntry(oldest);
+		}
+
+		entry = m_pool.allocate();
+		new (entry) Entry(key, value, hash, cost);
+
+		m_entries.push_front(*entry);
+		m_index.insert(entry);
+		m_used += cost;
+
+		return true;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lru_cache<K, V, Hash, Sizer, Allocator>::erase(const K& key)
+	{
+		Entry* entry = m_index.find(key, Hash()(key));
+
+		if (entry == nullptr)
+			return false;
+
+		removeEntry(entry);
+
+		return true;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lru_cache<K, V, Hash, Sizer, Allocator>::clear()
+	{
+		while (!m_entries.empty())
+		{
+			Entry* entry = &m_entries.front();
+
+			m_entries.pop_front();
+
+			entry->~Entry();
+			m_pool.deallocate(entry);
+		}
+
+		m_index.clear();
+		m_used = 0;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::size() const
+	{
+		return m_entries.size();
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::used() const
+	{
+		return m_used;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::capacity() const
+	{
+		return m_capacity;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::hits() const
+	{
+		return m_hits;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::misses() const
+	{
+		return m_misses;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lru_cache<K, V, Hash, Sizer, Allocator>::set_eviction_callback(eviction_callback callback)
+	{
+		m_onEvict = std::move(callback);
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lru_cache<K, V, Hash, Sizer, Allocator>::entryCost(const K& key, const V& value) const
+	{
+		return m_unit == cache_capacity::bytes ? Sizer()(key, value) : 1;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lru_cache<K, V, Hash, Sizer, Allocator>::removeEntry(Entry* entry)
+	{
+		m_entries.remove(*entry);
+		m_index.erase(entry);
+		m_used -= entry->m_cost;
+
+		entry->~Entry();
+		m_pool.deallocate(entry);
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lfu_cache<K, V, Hash, Sizer, Allocator>::Entry::Entry(const K& key, const V& value, const size_t hash,
+		const size_t cost) : m_key(key), m_value(value), m_hash(hash), m_cost(cost), m_bucket(nullptr)
+	{
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lfu_cache<K, V, Hash, Sizer, Allocator>::Bucket::Bucket(const size_t frequency) : m_frequency(frequency)
+	{
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lfu_cache<K, V, Hash, Sizer, Allocator>::lfu_cache(const size_t capacity, const cache_capacity unit) :
+		m_unit(unit), m_capacity(capacity), m_size(0), m_used(0), m_hits(0), m_misses(0)
+	{
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	lfu_cache<K, V, Hash, Sizer, Allocator>::~lfu_cache()
+	{
+		clear();
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	V* lfu_cache<K, V, Hash, Sizer, Allocator>::find(const K& key)
+	{
+		Entry* entry = m_index.find(key, Hash()(key));
+
+		if (entry == nullptr)
+		{
+			m_misses++;
+			return nullptr;
+		}
+
+		m_hits++;
+		touch(entry);
+
+		return &entry->m_value;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lfu_cache<K, V, Hash, Sizer, Allocator>::contains(const K& key) const
+	{
+		return m_index.find(key, Hash()(key)) != nullptr;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lfu_cache<K, V, Hash, Sizer, Allocator>::insert(const K& key, const V& value)
+	{
+		const size_t hash = Hash()(key);
+		const size_t cost = entryCost(key, value);
+
+		if (cost > m_capacity)
+			return false;
+
+		Entry* entry = m_index.find(key, hash);
+
+		if (entry != nullptr)
+			removeEntry(entry);
+
+		while (m_used + cost > m_capacity)
+		{
+			Entry* victim = &m_buckets.front().m_entries.back();
+
+			if (m_onEvict)
+				m_onEvict(victim->m_key, victim->m_value);
+
+			removeEntry(victim);
+		}
+
+		entry = m_entryPool.allocate();
+		new (entry) Entry(key, value, hash, cost);
+
+		linkEntry(entry, m_buckets.begin(), 1);
+		m_index.insert(entry);
+		m_size++;
+		m_used += cost;
+
+		return true;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	bool lfu_cache<K, V, Hash, Sizer, Allocator>::erase(const K& key)
+	{
+		Entry* entry = m_index.find(key, Hash()(key));
+
+		if (entry == nullptr)
+			return false;
+
+		removeEntry(entry);
+
+		return true;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::clear()
+	{
+		while (!m_buckets.empty())
+		{
+			Bucket* bucket = &m_buckets.front();
+
+			while (!bucket->m_entries.empty())
+			{
+				Entry* entry = &bucket->m_entries.front();
+
+				bucket->m_entries.pop_front();
+
+				entry->~Entry();
+				m_entryPool.deallocate(entry);
+			}
+
+			m_buckets.pop_front();
+
+			bucket->~Bucket();
+			m_bucketPool.deallocate(bucket);
+		}
+
+		m_index.clear();
+		m_size = 0;
+		m_used = 0;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::used() const
+	{
+		return m_used;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::capacity() const
+	{
+		return m_capacity;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::hits() const
+	{
+		return m_hits;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::misses() const
+	{
+		return m_misses;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::frequency(const K& key) const
+	{
+		const Entry* entry = m_index.find(key, Hash()(key));
+
+		return entry ? entry->m_bucket->m_frequency : 0;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::set_eviction_callback(eviction_callback callback)
+	{
+		m_onEvict = std::move(callback);
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	size_t lfu_cache<K, V, Hash, Sizer, Allocator>::entryCost(const K& key, const V& value) const
+	{
+		return m_unit == cache_capacity::bytes ? Sizer()(key, value) : 1;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::touch(Entry* entry)
+	{
+		Bucket* bucket = entry->m_bucket;
+
+		typename BucketList::iterator next(bucket);
+		++next;
+
+		const size_t frequency = bucket->m_frequency + 1;
+
+		unlinkEntry(entry);
+		linkEntry(entry, next, frequency);
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::linkEntry(Entry* entry, typename BucketList::iterator next,
+		const size_t frequency)
+	{
+		// Buckets are sorted by frequency, the one we need is either next or missing right before it
+		Bucket* bucket;
+
+		if (next != m_buckets.end() && next->m_frequency == frequency)
+		{
+			bucket = &*next;
+		}
+		else
+		{
+			bucket = m_bucketPool.allocate();
+			new (bucket) Bucket(frequency);
+
+			m_buckets.insert(next, *bucket);
+		}
+
+		bucket->m_entries.push_front(*entry);
+		entry->m_bucket = bucket;
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::unlinkEntry(Entry* entry)
+	{
+		Bucket* bucket = entry->m_bucket;
+
+		bucket->m_entries.remove(*entry);
+		entry->m_bucket = nullptr;
+
+		if (!bucket->m_entries.empty())
+			return;
+
+		m_buckets.remove(*bucket);
+
+		bucket->~Bucket();
+		m_bucketPool.deallocate(bucket);
+	}
+
+	template <typename K, typename V, class Hash, class Sizer, class Allocator>
+	void lfu_cache<K, V, Hash, Sizer, Allocator>::removeEntry(Entry* entry)
+	{
+		unlinkEntry(entry);
+		m_index.erase(entry);
+		m_size--;
+		m_used -= entry->m_cost;
+
+		entry->~Entry();
+		m_entryPool.deallocate(entry);
+	}
+}
\ No newline at end of file
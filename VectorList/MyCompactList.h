@@ -0,0 +1,656 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "SpyAllocator.h"
+
+namespace my
+{
+	// A list keeping its nodes in one growable array and linking them with 32 bits indices.
+	// Nodes can be moved around as a single block since they never point to each other.
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class compact_list
+	{
+		class Slot;
+	public:
+		class const_iterator : public std::iterator<std::bidirectional_iterator_tag, T>
+		{
+			friend compact_list;
+
+		public:
+			const_iterator();
+			const_iterator(const compact_list* list, uint32_t index);
+			const_iterator(const const_iterator& other);
+			const_iterator(const_iterator&& other) noexcept;
+			~const_iterator() = default;
+
+			const_iterator&	operator=(const const_iterator& other);
+			const_iterator&	operator=(const_iterator&& other) noexcept;
+
+			bool			operator==(const const_iterator& other) const;
+			bool			operator!=(const const_iterator& other) const;
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			const_iterator&	operator--();
+			const_iterator	operator--(int);
+
+			T&				operator*();
+			T*				operator->();
+
+		private:
+			// The slots array can be reallocated, keep the list instead of a slot address
+			const compact_list*	m_list;
+			uint32_t			m_index;
+		};
+
+		typedef const_iterator iterator;
+
+		static const uint32_t npos = UINT32_MAX;
+
+		compact_list();
+		compact_list(const compact_list& other);
+		compact_list(compact_list&& other) noexcept;
+		~compact_list();
+
+		compact_list&	operator=(const compact_list& other);
+		compact_list&	operator=(compact_list&& other) noexcept;
+
+		iterator		begin();
+		iterator		end();
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+		T&				front();
+		T&				back();
+
+		T				front() const;
+		T				back() const;
+
+		size_t			size() const;
+		size_t			capacity() const;
+
+		void			push_back(const T& item);
+		void			push_back(T&& item);
+
+		template		<typename... Args>
+		void			emplace_back(Args... args);
+
+		iterator		insert(const_iterator it, const T& item);
+		iterator		insert(const_iterator it, size_t count, const T& item);
+		template		<typename U, typename = typename std::iterator_traits<U>::iterator_category>
+		iterator		insert(const_iterator it, U first, U last);
+
+		void			remove(const T& val);
+		void			reserve(size_t capacity);
+		void			clear();
+
+	private:
+		class Slot
+		{
+			friend	compact_list;
+		public:
+			T&			data();
+
+		private:
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type	m_data;
+
+			uint32_t	m_prev;
+			uint32_t	m_next; // Next free slot while the slot isn't used
+		};
+
+		typedef typename Allocator::template rebind<Slot>::other SlotAllocator;
+
+		Slot*		m_slots;
+		uint32_t	m_capacity;
+		uint32_t	m_used;	// Slots past this index have never been handed out
+		uint32_t	m_free;	// Head of the recycled slots chain
+		uint32_t	m_head;
+		uint32_t	m_tail;
+		size_t		m_size;
+
+		uint32_t	allocateSlot();
+		bool		isFull() const;
+		bool		isElement(const T& item) const;
+		void		freeSlot(uint32_t index);
+		void		linkSlot(uint32_t next, uint32_t index);
+		void		removeSlot(uint32_t index);
+		void		setCapacity(uint32_t capacity);
+	};
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::const_iterator::const_iterator() = default;
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::const_iterator::const_iterator(const compact_list* list, const uint32_t index)
+	{
+		m_list = list;
+		m_index = index;
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::const_iterator::const_iterator(const const_iterator& other) :
+		m_list(other.m_list), m_index(other.m_index)
+	{
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::const_iterator::const_iterator(const_iterator&& other) noexcept :
+		m_list(other.m_list), m_index(other.m_index)
+	{
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator& compact_list<T, Allocator>::const_iterator::operator=(
+		const const_iterator& other)
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_list = other.m_list;
+		this->m_index = other.m_index;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator& compact_list<T, Allocator>::const_iterator::operator=(
+		const_iterator&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_list = other.m_list;
+		this->m_index = other.m_index;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	bool compact_list<T, Allocator>::const_iterator::operator==(const const_iterator& other) const
+	{
+		return other.m_index == m_index;
+	}
+
+	template <typename T, class Allocator>
+	bool compact_list<T, Allocator>::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return other.m_index != m_index;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator& compact_list<T, Allocator>::const_iterator::operator++()
+	{
+		m_index = m_list->m_slots[m_index].m_next;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator compact_list<T, Allocator>::const_iterator::operator++(int)
+	{
+		const_iterator tmp = *this;
+		m_index = m_list->m_slots[m_index].m_next;
+		return tmp;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator& compact_list<T, Allocator>::const_iterator::operator--()
+	{
+		m_index = m_list->m_slots[m_index].m_prev;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator compact_list<T, Allocator>::const_iterator::operator--(int)
+	{
+		const_iterator tmp = *this;
+		m_index = m_list->m_slots[m_index].m_prev;
+		return tmp;
+	}
+
+	template <typename T, class Allocator>
+	T& compact_list<T, Allocator>::const_iterator::operator*()
+	{
+		return m_list->m_slots[m_index].data();
+	}
+
+	template <typename T, class Allocator>
+	T* compact_list<T, Allocator>::const_iterator::operator->()
+	{
+		return &m_list->m_slots[m_index].data();
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::compact_list() :
+		m_slots(nullptr), m_capacity(0), m_used(0), m_free(npos), m_head(npos), m_tail(npos), m_size(0)
+	{
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::compact_list(const compact_list& other) :
+		m_slots(nullptr), m_capacity(0), m_used(0), m_free(npos), m_head(npos), m_tail(npos), m_size(0)
+	{
+		// Copying in list order stores the copy in sequential slots
+		reserve(other.m_size);
+
+		for (const_iterator i = other.begin(); i != other.end(); ++i)
+			push_back(*i);
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::compact_list(compact_list&& other) noexcept
+	{
+		m_slots = other.m_slots;
+		m_capacity = other.m_capacity;
+		m_used = other.m_used;
+		m_free = other.m_free;
+		m_head = other.m_head;
+		m_tail = other.m_tail;
+		m_size = other.m_size;
+
+		other.m_slots = nullptr;
+		other.m_capacity = other.m_used = 0;
+		other.m_free = other.m_head = other.m_tail = npos;
+		other.m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>::~compact_list()
+	{
+		clear();
+
+		if (m_slots != nullptr)
+			SlotAllocator().deallocate(m_slots, m_capacity);
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>& compact_list<T, Allocator>::operator=(const compact_list& other)
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+		reserve(other.m_size);
+
+		for (const_iterator i = other.begin(); i != other.end(); ++i)
+			push_back(*i);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	compact_list<T, Allocator>& compact_list<T, Allocator>::operator=(compact_list&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+
+		if (m_slots != nullptr)
+			SlotAllocator().deallocate(m_slots, m_capacity);
+
+		m_slots = other.m_slots;
+		m_capacity = other.m_capacity;
+		m_used = other.m_used;
+		m_free = other.m_free;
+		m_head = other.m_head;
+		m_tail = other.m_tail;
+		m_size = other.m_size;
+
+		other.m_slots = nullptr;
+		other.m_capacity = other.m_used = 0;
+		other.m_free = other.m_head = other.m_tail = npos;
+		other.m_size = 0;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::iterator compact_list<T, Allocator>::begin()
+	{
+		return iterator(this, m_head);
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::iterator compact_list<T, Allocator>::end()
+	{
+		return iterator(this, npos);
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator compact_list<T, Allocator>::begin() const
+	{
+		return const_iterator(this, m_head);
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::const_iterator compact_list<T, Allocator>::end() const
+	{
+		return const_iterator(this, npos);
+	}
+
+	template <typename T, class Allocator>
+	T& compact_list<T, Allocator>::front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called front() on an empty compact list");
+
+		return m_slots[m_head].data();
+	}
+
+	template <typename T, class Allocator>
+	T& compact_list<T, Allocator>::back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called back() on an empty compact list");
+
+		return m_slots[m_tail].data();
+	}
+
+	template <typename T, class Allocator>
+	T compact_list<T, Allocator>::front() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called front() on an empty compact list");
+
+		return m_slots[m_head].data();
+	}
+
+	template <typename T, class Allocator>
+	T compact_list<T, Allocator>::back() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called back() on an empty compact list");
+
+		return m_slots[m_tail].data();
+	}
+
+	template <typename T, class Allocator>
+	size_t compact_list<T, Allocator>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename T, class Allocator>
+	size_t compact_list<T, Allocator>::capacity() const
+	{
+		return m_capacity;
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::push_back(const T& item)
+	{
+		// An element of this list would be relocated by the growth before being copied
+		if (isFull() && isElement(item))
+		{
+			push_back(T(item));
+			return;
+		}
+
+		const uint32_t index = allocateSlot();
+
+		new (&m_slots[index].m_data) T(item);
+		linkSlot(npos, index);
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::push_back(T&& item)
+	{
+		if (isFull() && isElement(item))
+		{
+			T moved(std::move(item));
+			push_back(std::move(moved));
+			return;
+		}
+
+		const uint32_t index = allocateSlot();
+
+		new (&m_slots[index].m_data) T(std::move(item));
+		linkSlot(npos, index);
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	void compact_list<T, Allocator>::emplace_back(Args... args)
+	{
+		const uint32_t index = allocateSlot();
+
+		new (&m_slots[index].m_data) T(args...);
+		linkSlot(npos, index);
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::iterator compact_list<T, Allocator>::insert(const_iterator it, const T& item)
+	{
+		if (isFull() && isElement(item))
+		{
+			const T copy(item);
+			return insert(it, copy);
+		}
+
+		const uint32_t index = allocateSlot();
+
+		new (&m_slots[index].m_data) T(item);
+		linkSlot(it.m_index, index);
+
+		return iterator(this, index);
+	}
+
+	template <typename T, class Allocator>
+	typename compact_list<T, Allocator>::iterator compact_list<T, Allocator>::insert(const const_iterator it,
+		const size_t count, const T& item)
+	{
+		if (count == 0)
+			return it;
+
+		if (m_size + count > m_capacity && isElement(item))
+		{
+			const T copy(item);
+			return insert(it, count, copy);
+		}
+
+		reserve(m_size + count);
+
+		iterator result = insert(it, item);
+
+		for (size_t i = 1; i < count; i++)
+			insert(it, item);
+
+		return result;
+	}
+
+	template <typename T, class Allocator>
+	template <typename U, typename>
+	typename compact_list<T, Allocator>::iterator compact_list<T, Allocator>::insert(const const_iterator it,
+		U first, U last)
+	{
+		if (first == last)
+			return it;
+
+		iterator result = insert(it, *first++);
+
+		for (U item = first; item != last; ++item)
+			insert(it, *item);
+
+		return result;
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::remove(const T& val)
+	{
+		// An element of this list would be destroyed by the first match and still compared with the next ones
+		if (isElement(val))
+		{
+			const T copy(val);
+			remove(copy);
+			return;
+		}
+
+		uint32_t index = m_head;
+
+		while (index != npos)
+		{
+			const uint32_t next = m_slots[index].m_next;
+
+			if (val == m_slots[index].data())
+				removeSlot(index);
+
+			index = next;
+		}
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::reserve(const size_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return;
+
+		if (capacity >= npos)
+			throw std::length_error("Compact list capacity exceeds the index range");
+
+		setCapacity(static_cast<uint32_t>(capacity));
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::clear()
+	{
+		for (uint32_t index = m_head; index != npos; index = m_slots[index].m_next)
+			m_slots[index].data().~T();
+
+		// Every slot is free again, start handing them out from the beginning
+		m_used = 0;
+		m_free = m_head = m_tail = npos;
+		m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	T& compact_list<T, Allocator>::Slot::data()
+	{
+		return *reinterpret_cast<T*>(&m_data);
+	}
+
+	template <typename T, class Allocator>
+	uint32_t compact_list<T, Allocator>::allocateSlot()
+	{
+		if (m_free != npos)
+		{
+			const uint32_t index = m_free;
+			m_free = m_slots[index].m_next;
+			return index;
+		}
+
+		if (m_used == m_capacity)
+		{
+			if (m_capacity >= npos - 1)
+				throw std::length_error("Compact list capacity exceeds the index range");
+
+			const uint64_t capacity = m_capacity > 2 ? m_capacity + m_capacity / 2 : m_capacity + 1;
+			setCapacity(static_cast<uint32_t>(std::min<uint64_t>(capacity, npos - 1)));
+		}
+
+		return m_used++;
+	}
+
+	template <typename T, class Allocator>
+	bool compact_list<T, Allocator>::isFull() const
+	{
+		return m_free == npos && m_used == m_capacity;
+	}
+
+	template <typename T, class Allocator>
+	bool compact_list<T, Allocator>::isElement(const T& item) const
+	{
+		// std::less orders any two pointers, even ones to unrelated objects
+		const std::less<const void*> less;
+		const void* address = &item;
+
+		return m_slots != nullptr && !less(address, m_slots) && less(address, m_slots + m_capacity);
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::freeSlot(const uint32_t index)
+	{
+		m_slots[index].data().~T();
+
+		m_slots[index].m_prev = npos;
+		m_slots[index].m_next = m_free;
+		m_free = index;
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::linkSlot(const uint32_t next, const uint32_t index)
+	{
+		const uint32_t prev = next != npos ? m_slots[next].m_prev : m_tail;
+
+		m_slots[index].m_prev = prev;
+		m_slots[index].m_next = next;
+
+		if (prev != npos)
+			m_slots[prev].m_next = index;
+		else
+			m_head = index;
+
+		if (next != npos)
+			m_slots[next].m_prev = index;
+		else
+			m_tail = index;
+
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::removeSlot(const uint32_t index)
+	{
+		Slot& slot = m_slots[index];
+
+		if (slot.m_prev != npos)
+			m_slots[slot.m_prev].m_next = slot.m_next;
+		else
+			m_head = slot.m_next;
+
+		if (slot.m_next != npos)
+			m_slots[slot.m_next].m_prev = slot.m_prev;
+		else
+			m_tail = slot.m_prev;
+
+		freeSlot(index);
+
+		m_size--;
+	}
+
+	template <typename T, class Allocator>
+	void compact_list<T, Allocator>::setCapacity(const uint32_t capacity)
+	{
+		SlotAllocator	allocator;
+
+		Slot* slots = allocator.allocate(capacity);
+
+		if (m_slots != nullptr)
+		{
+			// Indices stay valid, only the links and the live elements have to be relocated
+			for (uint32_t i = 0; i < m_used; i++)
+			{
+				slots[i].m_prev = m_slots[i].m_prev;
+				slots[i].m_next = m_slots[i].m_next;
+			}
+
+			for (uint32_t index = m_head; index != npos; index = m_slots[index].m_next)
+			{
+				new (&slots[index].m_data) T(std::move(m_slots[index].data()));
+				m_slots[index].data().~T();
+			}
+
+			allocator.deallocate(m_slots, m_capacity);
+		}
+
+		m_slots = slots;
+		m_capacity = capacity;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,628 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "SpyAllocator.h"
+
+namespace my
+{
+	#define CACHE_LINE_SIZE 64
+
+	// Vyukov's multi-producer/single-consumer linked queue.
+	// Nodes are allocated once at construction and recycled through a lock-free free list,
+	// pushing and popping never reach the allocator.
+	// Only one thread at a time may call pop().
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class mpsc_queue
+	{
+	public:
+		explicit mpsc_queue(size_t capacity);
+		mpsc_queue(const mpsc_queue& other) = delete;
+		~mpsc_queue();
+
+		mpsc_queue&	operator=(const mpsc_queue& other) = delete;
+
+		bool		push(const T& item);
+		bool		push(T&& item);
+
+		template	<typename... Args>
+		bool		emplace(Args... args);
+
+		bool		pop(T& item);
+
+		size_t		capacity() const;
+
+	private:
+		class Node
+		{
+			friend	mpsc_queue;
+		public:
+			T&		data();
+
+		private:
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type	m_data;
+
+			std::atomic<Node*>		m_next;
+			std::atomic<uint32_t>	m_nextFree;
+		};
+
+		typedef typename Allocator::template rebind<Node>::other NodeAllocator;
+
+		static const uint32_t npos = UINT32_MAX;
+
+		Node*		m_nodes;
+		size_t		m_nodeCount;
+
+		alignas(CACHE_LINE_SIZE) std::atomic<Node*>		m_head;	// Last pushed node, shared by the producers
+		alignas(CACHE_LINE_SIZE) Node*					m_tail;	// Consumed stub node, only touched by the consumer
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>	m_free;	// Free list head index, tagged against ABA
+
+		Node*		acquireNode();
+		void		releaseNode(Node* node);
+		void		pushNode(Node* node);
+	};
+
+	// Vyukov's bounded multi-producer/multi-consumer array queue.
+	// Each cell carries a sequence number telling whether it is ready to be written or read.
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class mpmc_queue
+	{
+	public:
+		explicit mpmc_queue(size_t capacity);
+		mpmc_queue(const mpmc_queue& other) = delete;
+		~mpmc_queue();
+
+		mpmc_queue&	operator=(const mpmc_queue& other) = delete;
+
+		bool		push(const T& item);
+		bool		push(T&& item);
+
+		template	<typename... Args>
+		bool		emplace(Args... args);
+
+		bool		pop(T& item);
+
+		size_t		capacity() const;
+
+	private:
+		class Cell
+		{
+			friend	mpmc_queue;
+		public:
+			T&		data();
+
+		private:
+			std::atomic<size_t>	m_sequence;
+
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type	m_data;
+		};
+
+		typedef typename Allocator::template rebind<Cell>::other CellAllocator;
+
+		Cell*		m_cells;
+		size_t		m_mask;
+
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_enqueuePos;
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_dequeuePos;
+
+		Cell*		acquireEnqueueCell(size_t& pos);
+	};
+
+	// Lamport's bounded single-producer/single-consumer ring.
+	// Each side works from a cached copy of the other side's index and only loads the shared one
+	// when that copy says the ring is full or empty, the index cache lines barely bounce between cores.
+	// Only one thread at a time may push and only one at a time may pop.
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class spsc_queue
+	{
+	public:
+		explicit spsc_queue(size_t capacity);
+		spsc_queue(const spsc_queue& other) = delete;
+		~spsc_queue();
+
+		spsc_queue&	operator=(const spsc_queue& other) = delete;
+
+		bool		push(const T& item);
+		bool		push(T&& item);
+
+		template	<typename... Args>
+		bool		emplace(Args... args);
+
+		size_t		push(const T* items, size_t count);
+
+		bool		pop(T& item);
+		size_t		pop(T* items, size_t count);
+
+		size_t		capacity() const;
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Cell;
+		typedef typename Allocator::template rebind<Cell>::other CellAllocator;
+
+		Cell*		m_cells;
+		size_t		m_mask;
+
+		// Producer side
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_tail;
+		size_t											m_cachedHead;
+
+		// Consumer side
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t>	m_head;
+		size_t											m_cachedTail;
+
+		T*			cell(size_t pos) const;
+		size_t		freeCells(size_t tail, size_t count);
+		size_t		readyCells(size_t head, size_t count);
+	};
+
+	template <typename T, class Allocator>
+	mpsc_queue<T, Allocator>::mpsc_queue(const size_t capacity)
+	{
+		if (capacity >= npos)
+			throw std::length_error("mpsc_queue capacity exceeds the index range");
+
+		// One more node for the stub the consumer always holds on to
+		m_nodeCount = capacity + 1;
+		m_nodes = NodeAllocator().allocate(m_nodeCount);
+
+		for (size_t i = 0; i < m_nodeCount; i++)
+		{
+			new (&m_nodes[i].m_next) std::atomic<Node*>(nullptr);
+			new (&m_nodes[i].m_nextFree) std::atomic<uint32_t>(i + 1 < m_nodeCount ? static_cast<uint32_t>(i + 1) : npos);
+		}
+
+		// Without capacity the stub is the only node and nothing is ever free
+		m_free.store(m_nodeCount > 1 ? 1 : npos, std::memory_order_relaxed);
+
+		// The first node is the initial stub
+		m_head.store(&m_nodes[0], std::memory_order_relaxed);
+		m_tail = &m_nodes[0];
+	}
+
+	template <typename T, class Allocator>
+	mpsc_queue<T, Allocator>::~mpsc_queue()
+	{
+		for (Node* node = m_tail->m_next.load(std::memory_order_acquire); node != nullptr;
+			node = node->m_next.load(std::memory_order_acquire))
+			node->data().~T();
+
+		NodeAllocator().deallocate(m_nodes, m_nodeCount);
+	}
+
+	template <typename T, class Allocator>
+	bool mpsc_queue<T, Allocator>::push(const T& item)
+	{
+		Node* node = acquireNode();
+
+		if (node == nullptr)
+			return false;
+
+		new (&node->m_data) T(item);
+		pushNode(node);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool mpsc_queue<T, Allocator>::push(T&& item)
+	{
+		Node* node = acquireNode();
+
+		if (node == nullptr)
+			return false;
+
+		new (&node->m_data) T(std::move(item));
+		pushNode(node);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	bool mpsc_queue<T, Allocator>::emplace(Args... args)
+	{
+		Node* node = acquireNode();
+
+		if (node == nullptr)
+			return false;
+
+		new (&node->m_data) T(args...);
+		pushNode(node);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool mpsc_queue<T, Allocator>::pop(T& item)
+	{
+		Node* tail = m_tail;
+		Node* next = tail->m_next.load(std::memory_order_acquire);
+
+		// Either empty or a producer hasn't linked its node yet
+		if (next == nullptr)
+			return false;
+
+		item = std::move(next->data());
+		next->data().~T();
+
+		// The popped node becomes the new stub
+		m_tail = next;
+		releaseNode(tail);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	size_t mpsc_queue<T, Allocator>::capacity() const
+	{
+		return m_nodeCount - 1;
+	}
+
+	template <typename T, class Allocator>
+	T& mpsc_queue<T, Allocator>::Node::data()
+	{
+		return *reinterpret_cast<T*>(&m_data);
+	}
+
+	template <typename T, class Allocator>
+	typename mpsc_queue<T, Allocator>::Node* mpsc_queue<T, Allocator>::acquireNode()
+	{
+		uint64_t head = m_free.load(std::memory_order_acquire);
+
+		while (true)
+		{
+			const uint32_t index = static_cast<uint32_t>(head);
+
+			if (index == npos)
+				return nullptr;
+
+			const uint32_t next = m_nodes[index].m_nextFree.load(std::memory_order_relaxed);
+
+			// Bumping the tag makes a stale head fail the exchange even if the same index came back
+			const uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+
+			if (m_free.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+				return &m_nodes[index];
+		}
+	}
+
+	template <typename T, class Allocator>
+	void mpsc_queue<T, Allocator>::releaseNode(Node* node)
+	{
+		const uint32_t index = static_cast<uint32_t>(node - m_nodes);
+
+		uint64_t head = m_free.load(std::memory_order_relaxed);
+		uint64_t newHead;
+
+		do
+		{
+			node->m_nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+			newHead = ((head >> 32) + 1) << 32 | index;
+		}
+		while (!m_free.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	template <typename T, class Allocator>
+	void mpsc_queue<T, Allocator>::pushNode(Node* node)
+	{
+		node->m_next.store(nullptr, std::memory_order_relaxed);
+
+		Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+		prev->m_next.store(node, std::memory_order_release);
+	}
+
+	template <typename T, class Allocator>
+	mpmc_queue<T, Allocator>::mpmc_queue(const size_t capacity)
+	{
+		// Round the capacity up to a power of two to index the cells with a mask
+		size_t cellCount = 2;
+
+		while (cellCount < capacity)
+			cellCount <<= 1;
+
+		m_mask = cellCount - 1;
+		m_cells = CellAllocator().allocate(cellCount);
+
+		for (size_t i = 0; i < cellCount; i++)
+			new (&m_cells[i].m_sequence) std::atomic<size_t>(i);
+
+		m_enqueuePos.store(0, std::memory_order_relaxed);
+		m_dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	template <typename T, class Allocator>
+	mpmc_queue<T, Allocator>::~mpmc_queue()
+	{
+		const size_t end = m_enqueuePos.load(std::memory_order_relaxed);
+
+		for (size_t pos = m_dequeuePos.load(std::memory_order_relaxed); pos != end; pos++)
+			m_cells[pos & m_mask].data().~T();
+
+		CellAllocator().deallocate(m_cells, m_mask + 1);
+	}
+
+	template <typename T, class Allocator>
+	bool mpmc_queue<T, Allocator>::push(const T& item)
+	{
+		size_t	pos;
+		Cell*	cell = acquireEnqueueCell(pos);
+
+		if (cell == nullptr)
+			return false;
+
+		new (&cell->m_data) T(item);
+		cell->m_sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool mpmc_queue<T, Allocator>::push(T&& item)
+	{
+		size_t	pos;
+		Cell*	cell = acquireEnqueueCell(pos);
+
+		if (cell == nullptr)
+			return false;
+
+		new (&cell->m_data) T(std::move(item));
+		cell->m_sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	bool mpmc_queue<T, Allocator>::emplace(Args... args)
+	{
+		size_t	pos;
+		Cell*	cell = acquireEnqueueCell(pos);
+
+		if (cell == nullptr)
+			return false;
+
+		new (&cell->m_data) T(args...);
+		cell->m_sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool mpmc_queue<T, Allocator>::pop(T& item)
+	{
+		size_t	pos = m_dequeuePos.load(std::memory_order_relaxed);
+		Cell*	cell;
+
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+
+			const size_t	sequence = cell->m_sequence.load(std::memory_order_acquire);
+			const intptr_t	diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false; // Not written yet, the queue is empty
+			}
+			else
+			{
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		item = std::move(cell->data());
+		cell->data().~T();
+
+		// Ready to be written again on the next lap
+		cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	size_t mpmc_queue<T, Allocator>::capacity() const
+	{
+		return m_mask + 1;
+	}
+
+	template <typename T, class Allocator>
+	T& mpmc_queue<T, Allocator>::Cell::data()
+	{
+		return *reinterpret_cast<T*>(&m_data);
+	}
+
+	template <typename T, class Allocator>
+	typename mpmc_queue<T, Allocator>::Cell* mpmc_queue<T, Allocator>::acquireEnqueueCell(size_t& pos)
+	{
+		pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			Cell* cell = &m_cells[pos & m_mask];
+
+			const size_t	sequence = cell->m_sequence.load(std::memory_order_acquire);
+			const intptr_t	diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+			if (diff == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					return cell;
+			}
+			else if (diff < 0)
+			{
+				return nullptr; // Not read yet since the last lap, the queue is full
+			}
+			else
+			{
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template <typename T, class Allocator>
+	spsc_queue<T, Allocator>::spsc_queue(const size_t capacity) : m_cachedHead(0), m_cachedTail(0)
+	{
+		size_t cellCount = 2;
+
+		while (cellCount < capacity)
+			cellCount <<= 1;
+
+		m_mask = cellCount - 1;
+		m_cells = CellAllocator().allocate(cellCount);
+
+		m_tail.store(0, std::memory_order_relaxed);
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+	template <typename T, class Allocator>
+	spsc_queue<T, Allocator>::~spsc_queue()
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		for (size_t pos = m_head.load(std::memory_order_relaxed); pos != tail; pos++)
+			cell(pos)->~T();
+
+		CellAllocator().deallocate(m_cells, m_mask + 1);
+	}
+
+	template <typename T, class Allocator>
+	bool spsc_queue<T, Allocator>::push(const T& item)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (freeCells(tail, 1) == 0)
+			return false;
+
+		new (cell(tail)) T(item);
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool spsc_queue<T, Allocator>::push(T&& item)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (freeCells(tail, 1) == 0)
+			return false;
+
+		new (cell(tail)) T(std::move(item));
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	bool spsc_queue<T, Allocator>::emplace(Args... args)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (freeCells(tail, 1) == 0)
+			return false;
+
+		new (cell(tail)) T(args...);
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	size_t spsc_queue<T, Allocator>::push(const T* items, size_t count)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		count = freeCells(tail, count);
+
+		for (size_t i = 0; i < count; i++)
+			new (cell(tail + i)) T(items[i]);
+
+		// A single release publishes the whole batch
+		m_tail.store(tail + count, std::memory_order_release);
+
+		return count;
+	}
+
+	template <typename T, class Allocator>
+	bool spsc_queue<T, Allocator>::pop(T& item)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+
+		if (readyCells(head, 1) == 0)
+			return false;
+
+		item = std::move(*cell(head));
+		cell(head)->~T();
+
+		m_head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	size_t spsc_queue<T, Allocator>::pop(T* items, size_t count)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+
+		count = readyCells(head, count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			items[i] = std::move(*cell(head + i));
+			cell(head + i)->~T();
+		}
+
+		m_head.store(head + count, std::memory_order_release);
+
+		return count;
+	}
+
+	template <typename T, class Allocator>
+	size_t spsc_queue<T, Allocator>::capacity() const
+	{
+		return m_mask + 1;
+	}
+
+	template <typename T, class Allocator>
+	T* spsc_queue<T, Allocator>::cell(const size_t pos) const
+	{
+		return reinterpret_cast<T*>(&m_cells[pos & m_mask]);
+	}
+
+	template <typename T, class Allocator>
+	size_t spsc_queue<T, Allocator>::freeCells(const size_t tail, const size_t count)
+	{
+		size_t available = capacity() - (tail - m_cachedHead);
+
+		if (available < count)
+		{
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			available = capacity() - (tail - m_cachedHead);
+		}
+
+		return available < count ? available : count;
+	}
+
+	template <typename T, class Allocator>
+	size_t spsc_queue<T, Allocator>::readyCells(const size_t head, const size_t count)
+	{
+		size_t available = m_cachedTail - head;
+
+		if (available < count)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			available = m_cachedTail - head;
+		}
+
+		return available < count ? available : count;
+	}
+}
\ No newline at end of file
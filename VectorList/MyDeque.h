@@ -0,0 +1,627 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+#include "SpyAllocator.h"
+
+namespace my
+{
+	#define DEQUE_BLOCK_BYTES 512
+
+	// A double-ended queue keeping its elements in fixed-size blocks, reached through a circular map of block pointers.
+	// Blocks stay in the map once allocated, a queue of steady size keeps reusing them.
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class deque
+	{
+	public:
+		class const_iterator : public std::iterator<std::random_access_iterator_tag, T>
+		{
+			friend deque;
+
+		public:
+			const_iterator();
+			const_iterator(const deque* container, size_t index);
+			const_iterator(const const_iterator& other);
+			const_iterator(const_iterator&& other) noexcept;
+			~const_iterator() = default;
+
+			const_iterator&	operator=(const const_iterator& other);
+			const_iterator&	operator=(const_iterator&& other) noexcept;
+
+			bool			operator==(const const_iterator& other) const;
+			bool			operator!=(const const_iterator& other) const;
+			bool			operator<(const const_iterator& other) const;
+			bool			operator>(const const_iterator& other) const;
+			bool			operator<=(const const_iterator& other) const;
+			bool			operator>=(const const_iterator& other) const;
+
+			const_iterator	operator+(ptrdiff_t n) const;
+			const_iterator	operator-(ptrdiff_t n) const;
+			ptrdiff_t		operator-(const const_iterator& other) const;
+
+			const_iterator&	operator+=(ptrdiff_t n);
+			const_iterator&	operator-=(ptrdiff_t n);
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			const_iterator&	operator--();
+			const_iterator	operator--(int);
+
+			T&				operator*() const;
+			T*				operator->() const;
+			T&				operator[](ptrdiff_t n) const;
+
+		private:
+			// Growing the map rotates the blocks, keep the logical index rather than a map position
+			const deque*	m_deque;
+			size_t			m_index;
+		};
+
+		typedef const_iterator iterator;
+
+		// Elements per block
+		static const size_t blockSize = sizeof(T) < DEQUE_BLOCK_BYTES ? DEQUE_BLOCK_BYTES / sizeof(T) : 1;
+
+		deque();
+		deque(const deque& other);
+		deque(deque&& other) noexcept;
+		~deque();
+
+		deque&			operator=(const deque& other);
+		deque&			operator=(deque&& other) noexcept;
+
+		T&				operator[](size_t i);
+		const T&		operator[](size_t i) const;
+
+		iterator		begin();
+		iterator		end();
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+		T&				front();
+		T&				back();
+
+		const T&		front() const;
+		const T&		back() const;
+
+		size_t			size() const;
+		bool			empty() const;
+
+		void			push_back(const T& item);
+		void			push_back(T&& item);
+		void			push_front(const T& item);
+		void			push_front(T&& item);
+
+		template		<typename... Args>
+		void			emplace_back(Args... args);
+		template		<typename... Args>
+		void			emplace_front(Args... args);
+
+		void			pop_back();
+		void			pop_front();
+
+		void			clear();
+		void			shrink_to_fit();
+
+	private:
+		typedef typename Allocator::template rebind<T*>::other MapAllocator;
+
+		T**		m_map;
+		size_t	m_mapSize;
+		size_t	m_start; // Position of the front element, counted in elements from the start of the map
+		size_t	m_size;
+
+		size_t	capacity() const;
+		T*		slot(size_t index) const;
+		T*		backSlot();
+		T*		frontSlot();
+		void	growMap();
+		void	freeBlocks(bool keepLive);
+	};
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::const_iterator::const_iterator() : m_deque(nullptr), m_index(0)
+	{
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::const_iterator::const_iterator(const deque* container, const size_t index) :
+		m_deque(container), m_index(index)
+	{
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::const_iterator::const_iterator(const const_iterator& other) :
+		m_deque(other.m_deque), m_index(other.m_index)
+	{
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::const_iterator::const_iterator(const_iterator&& other) noexcept :
+		m_deque(other.m_deque), m_index(other.m_index)
+	{
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator=(
+		const const_iterator& other)
+	{
+		m_deque = other.m_deque;
+		m_index = other.m_index;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator=(
+		const_iterator&& other) noexcept
+	{
+		m_deque = other.m_deque;
+		m_index = other.m_index;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator==(const const_iterator& other) const
+	{
+		return m_index == other.m_index && m_deque == other.m_deque;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return !(*this == other);
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator<(const const_iterator& other) const
+	{
+		return m_index < other.m_index;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator>(const const_iterator& other) const
+	{
+		return m_index > other.m_index;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator<=(const const_iterator& other) const
+	{
+		return m_index <= other.m_index;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::const_iterator::operator>=(const const_iterator& other) const
+	{
+		return m_index >= other.m_index;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::const_iterator::operator+(const ptrdiff_t n) const
+	{
+		return const_iterator(m_deque, m_index + n);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::const_iterator::operator-(const ptrdiff_t n) const
+	{
+		return const_iterator(m_deque, m_index - n);
+	}
+
+	template <typename T, class Allocator>
+	ptrdiff_t deque<T, Allocator>::const_iterator::operator-(const const_iterator& other) const
+	{
+		return static_cast<ptrdiff_t>(m_index) - static_cast<ptrdiff_t>(other.m_index);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator+=(const ptrdiff_t n)
+	{
+		m_index += n;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator-=(const ptrdiff_t n)
+	{
+		m_index -= n;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator++()
+	{
+		m_index++;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::const_iterator::operator++(int)
+	{
+		const_iterator tmp = *this;
+		m_index++;
+		return tmp;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator& deque<T, Allocator>::const_iterator::operator--()
+	{
+		m_index--;
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::const_iterator::operator--(int)
+	{
+		const_iterator tmp = *this;
+		m_index--;
+		return tmp;
+	}
+
+	template <typename T, class Allocator>
+	T& deque<T, Allocator>::const_iterator::operator*() const
+	{
+		return *m_deque->slot(m_index);
+	}
+
+	template <typename T, class Allocator>
+	T* deque<T, Allocator>::const_iterator::operator->() const
+	{
+		return m_deque->slot(m_index);
+	}
+
+	template <typename T, class Allocator>
+	T& deque<T, Allocator>::const_iterator::operator[](const ptrdiff_t n) const
+	{
+		return *m_deque->slot(m_index + n);
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::deque() : m_map(nullptr), m_mapSize(0), m_start(0), m_size(0)
+	{
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::deque(const deque& other) : deque()
+	{
+		for (size_t i = 0; i < other.m_size; i++)
+			push_back(other[i]);
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::deque(deque&& other) noexcept :
+		m_map(other.m_map), m_mapSize(other.m_mapSize), m_start(other.m_start), m_size(other.m_size)
+	{
+		other.m_map = nullptr;
+		other.m_mapSize = 0;
+		other.m_start = 0;
+		other.m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>::~deque()
+	{
+		clear();
+		freeBlocks(false);
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>& deque<T, Allocator>::operator=(const deque& other)
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+
+		for (size_t i = 0; i < other.m_size; i++)
+			push_back(other[i]);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	deque<T, Allocator>& deque<T, Allocator>::operator=(deque&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+		freeBlocks(false);
+
+		m_map = other.m_map;
+		m_mapSize = other.m_mapSize;
+		m_start = other.m_start;
+		m_size = other.m_size;
+
+		other.m_map = nullptr;
+		other.m_mapSize = 0;
+		other.m_start = 0;
+		other.m_size = 0;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	T& deque<T, Allocator>::operator[](const size_t i)
+	{
+		return *slot(i);
+	}
+
+	template <typename T, class Allocator>
+	const T& deque<T, Allocator>::operator[](const size_t i) const
+	{
+		return *slot(i);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::iterator deque<T, Allocator>::begin()
+	{
+		return iterator(this, 0);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::iterator deque<T, Allocator>::end()
+	{
+		return iterator(this, m_size);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::begin() const
+	{
+		return const_iterator(this, 0);
+	}
+
+	template <typename T, class Allocator>
+	typename deque<T, Allocator>::const_iterator deque<T, Allocator>::end() const
+	{
+		return const_iterator(this, m_size);
+	}
+
+	template <typename T, class Allocator>
+	T& deque<T, Allocator>::front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		return *slot(0);
+	}
+
+	template <typename T, class Allocator>
+	T& deque<T, Allocator>::back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		return *slot(m_size - 1);
+	}
+
+	template <typename T, class Allocator>
+	const T& deque<T, Allocator>::front() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		return *slot(0);
+	}
+
+	template <typename T, class Allocator>
+	const T& deque<T, Allocator>::back() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		return *slot(m_size - 1);
+	}
+
+	template <typename T, class Allocator>
+	size_t deque<T, Allocator>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename T, class Allocator>
+	bool deque<T, Allocator>::empty() const
+	{
+		return m_size == 0;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::push_back(const T& item)
+	{
+		new (backSlot()) T(item);
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::push_back(T&& item)
+	{
+		new (backSlot()) T(std::move(item));
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::push_front(const T& item)
+	{
+		new (frontSlot()) T(item);
+		m_start = m_start == 0 ? capacity() - 1 : m_start - 1;
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::push_front(T&& item)
+	{
+		new (frontSlot()) T(std::move(item));
+		m_start = m_start == 0 ? capacity() - 1 : m_start - 1;
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	void deque<T, Allocator>::emplace_back(Args... args)
+	{
+		new (backSlot()) T(args...);
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	void deque<T, Allocator>::emplace_front(Args... args)
+	{
+		new (frontSlot()) T(args...);
+		m_start = m_start == 0 ? capacity() - 1 : m_start - 1;
+		m_size++;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::pop_back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		slot(m_size - 1)->~T();
+		m_size--;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::pop_front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty deque");
+
+		slot(0)->~T();
+
+		if (++m_start == capacity())
+			m_start = 0;
+
+		m_size--;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::clear()
+	{
+		for (size_t i = 0; i < m_size; i++)
+			slot(i)->~T();
+
+		m_start = 0;
+		m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::shrink_to_fit()
+	{
+		freeBlocks(true);
+	}
+
+	template <typename T, class Allocator>
+	size_t deque<T, Allocator>::capacity() const
+	{
+		return m_mapSize * blockSize;
+	}
+
+	template <typename T, class Allocator>
+	T* deque<T, Allocator>::slot(const size_t index) const
+	{
+		size_t position = m_start + index;
+
+		if (position >= capacity())
+			position -= capacity();
+
+		return m_map[position / blockSize] + position % blockSize;
+	}
+
+	template <typename T, class Allocator>
+	T* deque<T, Allocator>::backSlot()
+	{
+		// Keep a whole block free so the front and back blocks never share a map entry
+		if (m_size + 1 + blockSize > capacity())
+			growMap();
+
+		size_t position = m_start + m_size;
+
+		if (position >= capacity())
+			position -= capacity();
+
+		T*& block = m_map[position / blockSize];
+
+		if (block == nullptr)
+			block = Allocator().allocate(blockSize);
+
+		return block + position % blockSize;
+	}
+
+	template <typename T, class Allocator>
+	T* deque<T, Allocator>::frontSlot()
+	{
+		if (m_size + 1 + blockSize > capacity())
+			growMap();
+
+		const size_t position = m_start == 0 ? capacity() - 1 : m_start - 1;
+
+		T*& block = m_map[position / blockSize];
+
+		if (block == nullptr)
+			block = Allocator().allocate(blockSize);
+
+		return block + position % blockSize;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::growMap()
+	{
+		const size_t mapSize = m_mapSize == 0 ? 4 : m_mapSize * 2;
+
+		T** map = MapAllocator().allocate(mapSize);
+
+		// Rotate the block pointers so the front block comes first, elements keep their place inside the blocks
+		const size_t firstBlock = m_start / blockSize;
+
+		for (size_t i = 0; i < m_mapSize; i++)
+			map[i] = m_map[(firstBlock + i) % m_mapSize];
+
+		for (size_t i = m_mapSize; i < mapSize; i++)
+			map[i] = nullptr;
+
+		if (m_map != nullptr)
+			MapAllocator().deallocate(m_map, m_mapSize);
+
+		m_map = map;
+		m_mapSize = mapSize;
+		m_start %= blockSize;
+	}
+
+	template <typename T, class Allocator>
+	void deque<T, Allocator>::freeBlocks(const bool keepLive)
+	{
+		if (m_map == nullptr)
+			return;
+
+		const size_t firstBlock = m_start / blockSize;
+		const size_t liveBlocks = m_size == 0 ? 0 : (m_start % blockSize + m_size - 1) / blockSize + 1;
+
+		for (size_t i = keepLive ? liveBlocks : 0; i < m_mapSize; i++)
+		{
+			T*& block = m_map[(firstBlock + i) % m_mapSize];
+
+			if (block == nullptr)
+				continue;
+
+			Allocator().deallocate(block, blockSize);
+			block = nullptr;
+		}
+
+		if (keepLive && liveBlocks > 0)
+			return;
+
+		MapAllocator().deallocate(m_map, m_mapSize);
+
+		m_map = nullptr;
+		m_mapSize = 0;
+		m_start = 0;
+	}
+}
\ No newline at end of file
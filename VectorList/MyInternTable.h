@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include "MyCache.h"
+#include "MyString.h"
+#include "MyStringView.h"
+#include "SpyAllocator.h"
+
+namespace my
+{
+	#define INTERN_TABLE_SHARD_COUNT 16
+
+	#ifndef CACHE_LINE_SIZE
+	#define CACHE_LINE_SIZE 64
+	#endif
+
+	namespace detail
+	{
+		// The characters of the interned string follow the entry in the same block
+		template <typename T>
+		struct intern_entry
+		{
+			basic_string_view<T>	m_key;
+			size_t					m_hash;
+			size_t					m_id;
+			intern_entry*			m_next; // Entries of the same shard, to free them
+		};
+	}
+
+	template <typename T, class Allocator>
+	class basic_intern_table;
+
+	// Handle to a string interned in a table, it stays valid as long as the table.
+	// Handles of the same table are equal when their strings are, comparing and hashing them never reads the strings.
+	template <typename T = char>
+	class interned_string
+	{
+		template <typename U, class Allocator>
+		friend class basic_intern_table;
+
+	public:
+		interned_string();
+
+		bool			operator==(const interned_string& other) const;
+		bool			operator!=(const interned_string& other) const;
+		bool			operator<(const interned_string& other) const;
+
+		explicit		operator bool() const;
+		operator		basic_string_view<T>() const;
+
+		size_t			id() const;
+		size_t			hash() const;
+		size_t			size() const;
+		const T*		c_str() const;
+
+	private:
+		explicit interned_string(const detail::intern_entry<T>* entry);
+
+		size_t							m_id;
+		const detail::intern_entry<T>*	m_entry;
+	};
+
+	// Maps string contents to a single shared copy.
+	// Strings are spread over INTERN_TABLE_SHARD_COUNT shards by hash, each behind its own lock,
+	// the allocator is only ever called by one thread at a time.
+	// Every string found already interned is reported to the memory spy as saved bytes.
+	template <typename T = char, class Allocator = SpyAllocator<T>>
+	class basic_intern_table
+	{
+	public:
+		typedef interned_string<T> handle;
+
+		basic_intern_table();
+		basic_intern_table(const basic_intern_table& other) = delete;
+		~basic_intern_table();
+
+		basic_intern_table&	operator=(const basic_intern_table& other) = delete;
+
+		handle			intern(basic_string_view<T> str);
+		handle			find(basic_string_view<T> str) const;
+
+		// Reuse the hash a heap string keeps in its block
+		template <class StringAllocator>
+		handle			intern(const basic_string<T, StringAllocator>& str);
+		template <class StringAllocator>
+		handle			find(const basic_string<T, StringAllocator>& str) const;
+
+		size_t			size() const;
+		size_t			saved_bytes() const;
+
+	private:
+		typedef detail::intern_entry<T>											Entry;
+		typedef std::hash<basic_string_view<T>>									Hash;
+		typedef detail::cache_index<Entry, basic_string_view<T>, Hash, Allocator>	EntryIndex;
+		typedef typename Allocator::template rebind<char>::other				ByteAllocator;
+
+		struct alignas(CACHE_LINE_SIZE) Shard
+		{
+			mutable std::mutex	m_mutex;
+			EntryIndex			m_index;
+			Entry*				m_entries;
+			size_t				m_count;
+		};
+
+		Shard				m_shards[INTERN_TABLE_SHARD_COUNT];
+		std::mutex			m_allocatorMutex;
+		std::atomic<size_t>	m_savedBytes;
+
+		handle			intern(basic_string_view<T> str, size_t hash);
+		handle			find(basic_string_view<T> str, size_t hash) const;
+
+		static size_t	shardOf(size_t hash);
+		static size_t	blockSize(size_t size);
+	};
+
+	using intern_table = basic_intern_table<char, SpyAllocator<char>>;
+
+	template <typename T>
+	interned_string<T>::interned_string() : m_id(0), m_entry(nullptr)
+	{
+	}
+
+	template <typename T>
+	interned_string<T>::interned_string(const detail::intern_entry<T>* entry) : m_id(entry->m_id), m_entry(entry)
+	{
+	}
+
+	template <typename T>
+	bool interned_string<T>::operator==(const interned_string& other) const
+	{
+		return m_entry == other.m_entry;
+	}
+
+	template <typename T>
+	bool interned_string<T>::operator!=(const interned_string& other) const
+	{
+		return m_entry != other.m_entry;
+	}
+
+	template <typename T>
+	bool interned_string<T>::operator<(const interned_string& other) const
+	{
+		return m_id < other.m_id;
+	}
+
+	template <typename T>
+	interned_string<T>::operator bool() const
+	{
+		return m_entry != nullptr;
+	}
+
+	template <typename T>
+	interned_string<T>::operator basic_string_view<T>() const
+	{
+		return m_entry != nullptr ? m_entry->m_key : basic_string_view<T>();
+	}
+
+	template <typename T>
+	size_t interned_string<T>::id() const
+	{
+		return m_id;
+	}
+
+	template <typename T>
+	size_t interned_string<T>::hash() const
+	{
+		// Ids are small and dense, multiplied to spread them over the whole range
+		return m_id * static_cast<size_t>(0x9E3779B97F4A7C15ull);
+	}
+
+	template <typename T>
+	size_t interned_string<T>::size() const
+	{
+		return m_entry != nullptr ? m_entry->m_key.size() : 0;
+	}
+
+	template <typename T>
+	const T* interned_string<T>::c_str() const
+	{
+		return m_entry != nullptr ? m_entry->m_key.data() : nullptr;
+	}
+
+	template <typename T, class Allocator>
+	basic_intern_table<T, Allocator>::basic_intern_table() : m_savedBytes(0)
+	{
+		for (Shard& shard : m_shards)
+		{
+			shard.m_entries = nullptr;
+			shard.m_count = 0;
+		}
+	}
+
+	template <typename T, class Allocator>
+	basic_intern_table<T, Allocator>::~basic_intern_table()
+	{
+		for (Shard& shard : m_shards)
+		{
+			while (shard.m_entries != nullptr)
+			{
+				Entry* next = shard.m_entries->m_next;
+				const size_t size = blockSize(shard.m_entries->m_key.size());
+
+				shard.m_entries->~Entry();
+				ByteAllocator().deallocate(reinterpret_cast<char*>(shard.m_entries), size);
+
+				shard.m_entries = next;
+			}
+		}
+	}
+
+	template <typename T, class Allocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::intern(
+		const basic_string_view<T> str)
+	{
+		return intern(str, Hash()(str));
+	}
+
+	template <typename T, class Allocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::find(
+		const basic_string_view<T> str) const
+	{
+		return find(str, Hash()(str));
+	}
+
+	template <typename T, class Allocator>
+	template <class StringAllocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::intern(
+		const basic_string<T, StringAllocator>& str)
+	{
+		return intern(str, str.hash());
+	}
+
+	template <typename T, class Allocator>
+	template <class StringAllocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::find(
+		const basic_string<T, StringAllocator>& str) const
+	{
+		return find(str, str.hash());
+	}
+
+	template <typename T, class Allocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::intern(
+		const basic_string_view<T> str, const size_t hash)
+	{
+		Shard& shard = m_shards[shardOf(hash)];
+
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+		const Entry* found = shard.m_index.find(str, hash);
+
+		if (found != nullptr)
+		{
+			const size_t saved = (str.size() + 1) * sizeof(T);
+
+			m_savedBytes.fetch_add(saved, std::memory_order_relaxed);
+			g_memorySpy.NotifyDedup(saved);
+
+			return handle(found);
+		}
+
+		// Ids are unique across shards, the low part is the shard
+		const size_t id = shard.m_count * INTERN_TABLE_SHARD_COUNT + shardOf(hash);
+
+		std::lock_guard<std::mutex> allocatorLock(m_allocatorMutex);
+
+		char*	block = ByteAllocator().allocate(blockSize(str.size()));
+		T*		chars = reinterpret_cast<T*>(block + sizeof(Entry));
+
+		std::copy(str.begin(), str.end(), chars);
+		chars[str.size()] = static_cast<T>(0);
+
+		Entry* entry = new (block) Entry{ basic_string_view<T>(chars, str.size()), hash, id, shard.m_entries };
+
+		// Growing the index allocates, the entry is only linked once it is indexed
+		try
+		{
+			shard.m_index.insert(entry);
+		}
+		catch (...)
+		{
+			entry->~Entry();
+			ByteAllocator().deallocate(block, blockSize(str.size()));
+			throw;
+		}
+
+		shard.m_entries = entry;
+		shard.m_count++;
+
+		return handle(entry);
+	}
+
+	template <typename T, class Allocator>
+	typename basic_intern_table<T, Allocator>::handle basic_intern_table<T, Allocator>::find(
+		const basic_string_view<T> str, const size_t hash) const
+	{
+		const Shard& shard = m_shards[shardOf(hash)];
+
+		std::lock_guard<std::mutex> lock(shard.m_mutex);
+
+		const Entry* found = shard.m_index.find(str, hash);
+
+		return found != nullptr ? handle(found) : handle();
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_intern_table<T, Allocator>::size() const
+	{
+		size_t size = 0;
+
+		for (const Shard& shard : m_shards)
+		{
+			std::lock_guard<std::mutex> lock(shard.m_mutex);
+			size += shard.m_count;
+		}
+
+		return size;
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_intern_table<T, Allocator>::saved_bytes() const
+	{
+		return m_savedBytes.load(std::memory_order_relaxed);
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_intern_table<T, Allocator>::shardOf(const size_t hash)
+	{
+		// The low bits pick the slot in the shard index
+		return (hash >> (sizeof(size_t) * 8 - 16)) % INTERN_TABLE_SHARD_COUNT;
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_intern_table<T, Allocator>::blockSize(const size_t size)
+	{
+		static_assert(sizeof(Entry) % alignof(T) == 0, "The characters must be aligned right after the entry");
+
+		return sizeof(Entry) + (size + 1) * sizeof(T);
+	}
+}
+
+namespace std
+{
+	template <typename T>
+	struct hash<my::interned_string<T>>
+	{
+		size_t	operator()(const my::interned_string<T>& str) const
+		{
+			return str.hash();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <iterator>
+#include <stdexcept>
+
+namespace my
+{
+	template <typename T>
+	class intrusive_list_hook
+	{
+		template <typename U, intrusive_list_hook<U> U::* Hook>
+		friend class intrusive_list;
+
+	public:
+		intrusive_list_hook();
+
+		// The links belong to the list the object is in, copying an object must not copy them
+		intrusive_list_hook(const intrusive_list_hook& other);
+		~intrusive_list_hook() = default;
+
+		intrusive_list_hook&	operator=(const intrusive_list_hook& other);
+
+	private:
+		T*	m_prev;
+		T*	m_next;
+	};
+
+	// A list threading objects through a hook member they already own.
+	// The list never allocates, copies or destroys the linked objects.
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	class intrusive_list
+	{
+	public:
+		class const_iterator : public std::iterator<std::bidirectional_iterator_tag, T>
+		{
+			friend intrusive_list;
+
+		public:
+			const_iterator();
+			const_iterator(T* item);
+			const_iterator(const const_iterator& other);
+			const_iterator(const_iterator&& other) noexcept;
+			~const_iterator() = default;
+
+			const_iterator&	operator=(const const_iterator& other);
+			const_iterator&	operator=(const_iterator&& other) noexcept;
+
+			bool			operator==(const const_iterator& other) const;
+			bool			operator!=(const const_iterator& other) const;
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			const_iterator&	operator--();
+			const_iterator	operator--(int);
+
+			T&				operator*();
+			T*				operator->();
+
+		private:
+			T*	m_item;
+		};
+
+		typedef const_iterator iterator;
+
+		intrusive_list();
+		intrusive_list(const intrusive_list& other) = delete;
+		intrusive_list(intrusive_list&& other) noexcept;
+		~intrusive_list();
+
+		intrusive_list&	operator=(const intrusive_list& other) = delete;
+		intrusive_list&	operator=(intrusive_list&& other) noexcept;
+
+		iterator		begin();
+		iterator		end();
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+		T&				front();
+		T&				back();
+
+		size_t			size() const;
+		bool			empty() const;
+
+		void			push_back(T& item);
+		void			push_front(T& item);
+
+		void			pop_back();
+		void			pop_front();
+
+		iterator		insert(const_iterator it, T& item);
+		iterator		erase(const_iterator it);
+
+		void			splice(const_iterator it, intrusive_list& other);
+		void			splice(const_iterator it, intrusive_list& other, const_iterator item);
+
+		void			remove(T& item);
+		void			clear();
+
+	private:
+		T*		m_head;
+		T*		m_tail;
+		size_t	m_size;
+
+		static intrusive_list_hook<T>&	hook(T* item);
+
+		void	link(T* next, T* item);
+		void	unlink(T* item);
+	};
+
+	template <typename T>
+	intrusive_list_hook<T>::intrusive_list_hook() : m_prev(nullptr), m_next(nullptr)
+	{
+	}
+
+	template <typename T>
+	intrusive_list_hook<T>::intrusive_list_hook(const intrusive_list_hook&) : m_prev(nullptr), m_next(nullptr)
+	{
+	}
+
+	template <typename T>
+	intrusive_list_hook<T>& intrusive_list_hook<T>::operator=(const intrusive_list_hook&)
+	{
+		// Keep our own links, the assigned object stays wherever it currently is
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::const_iterator::const_iterator() = default;
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::const_iterator::const_iterator(T* item)
+	{
+		m_item = item;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::const_iterator::const_iterator(const const_iterator& other) : m_item(other.m_item)
+	{
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::const_iterator::const_iterator(const_iterator&& other) noexcept : m_item(other.m_item)
+	{
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator& intrusive_list<T, Hook>::const_iterator::operator=(
+		const const_iterator& other)
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_item = other.m_item;
+
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator& intrusive_list<T, Hook>::const_iterator::operator=(
+		const_iterator&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_item = other.m_item;
+
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	bool intrusive_list<T, Hook>::const_iterator::operator==(const const_iterator& other) const
+	{
+		return other.m_item == m_item;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	bool intrusive_list<T, Hook>::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return other.m_item != m_item;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator& intrusive_list<T, Hook>::const_iterator::operator++()
+	{
+		m_item = hook(m_item).m_next;
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator intrusive_list<T, Hook>::const_iterator::operator++(int)
+	{
+		const_iterator tmp = *this;
+		m_item = hook(m_item).m_next;
+		return tmp;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator& intrusive_list<T, Hook>::const_iterator::operator--()
+	{
+		m_item = hook(m_item).m_prev;
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator intrusive_list<T, Hook>::const_iterator::operator--(int)
+	{
+		const_iterator tmp = *this;
+		m_item = hook(m_item).m_prev;
+		return tmp;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	T& intrusive_list<T, Hook>::const_iterator::operator*()
+	{
+		return *m_item;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	T* intrusive_list<T, Hook>::const_iterator::operator->()
+	{
+		return m_item;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::intrusive_list() : m_head(nullptr), m_tail(nullptr), m_size(0)
+	{
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::intrusive_list(intrusive_list&& other) noexcept
+	{
+		m_head = other.m_head;
+		m_tail = other.m_tail;
+		m_size = other.m_size;
+
+		other.m_head = other.m_tail = nullptr;
+		other.m_size = 0;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>::~intrusive_list()
+	{
+		clear();
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list<T, Hook>& intrusive_list<T, Hook>::operator=(intrusive_list&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+
+		m_head = other.m_head;
+		m_tail = other.m_tail;
+		m_size = other.m_size;
+
+		other.m_head = other.m_tail = nullptr;
+		other.m_size = 0;
+
+		return *this;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::iterator intrusive_list<T, Hook>::begin()
+	{
+		return iterator(m_head);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::iterator intrusive_list<T, Hook>::end()
+	{
+		return iterator(nullptr);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator intrusive_list<T, Hook>::begin() const
+	{
+		return const_iterator(m_head);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::const_iterator intrusive_list<T, Hook>::end() const
+	{
+		return const_iterator(nullptr);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	T& intrusive_list<T, Hook>::front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called front() on an empty intrusive list");
+
+		return *m_head;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	T& intrusive_list<T, Hook>::back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called back() on an empty intrusive list");
+
+		return *m_tail;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	size_t intrusive_list<T, Hook>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	bool intrusive_list<T, Hook>::empty() const
+	{
+		return m_size == 0;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::push_back(T& item)
+	{
+		link(nullptr, &item);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::push_front(T& item)
+	{
+		link(m_head, &item);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::pop_back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called pop_back() on an empty intrusive list");
+
+		unlink(m_tail);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::pop_front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Called pop_front() on an empty intrusive list");
+
+		unlink(m_head);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::iterator intrusive_list<T, Hook>::insert(const_iterator it, T& item)
+	{
+		link(it.m_item, &item);
+		return iterator(&item);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	typename intrusive_list<T, Hook>::iterator intrusive_list<T, Hook>::erase(const_iterator it)
+	{
+		T* next = hook(it.m_item).m_next;
+
+		unlink(it.m_item);
+
+		return iterator(next);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::splice(const_iterator it, intrusive_list& other)
+	{
+		if (&other == this || other.m_size == 0)
+			return;
+
+		T* next = it.m_item;
+		T* prev = next ? hook(next).m_prev : m_tail;
+
+		// Relink the whole chain of the other list at once
+		hook(other.m_head).m_prev = prev;
+		hook(other.m_tail).m_next = next;
+
+		if (prev)
+			hook(prev).m_next = other.m_head;
+		else
+			m_head = other.m_head;
+
+		if (next)
+			hook(next).m_prev = other.m_tail;
+		else
+			m_tail = other.m_tail;
+
+		m_size += other.m_size;
+
+		other.m_head = other.m_tail = nullptr;
+		other.m_size = 0;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::splice(const_iterator it, intrusive_list& other, const_iterator item)
+	{
+		if (it == item)
+			return;
+
+		other.unlink(item.m_item);
+		link(it.m_item, item.m_item);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::remove(T& item)
+	{
+		unlink(&item);
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::clear()
+	{
+		T* item = m_head;
+
+		// Reset the hooks so the objects can be linked again
+		while (item)
+		{
+			T* next = hook(item).m_next;
+
+			hook(item).m_prev = nullptr;
+			hook(item).m_next = nullptr;
+
+			item = next;
+		}
+
+		m_head = m_tail = nullptr;
+		m_size = 0;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	intrusive_list_hook<T>& intrusive_list<T, Hook>::hook(T* item)
+	{
+		return item->*Hook;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::link(T* next, T* item)
+	{
+		T* prev = next ? hook(next).m_prev : m_tail;
+
+		hook(item).m_prev = prev;
+		hook(item).m_next = next;
+
+		if (prev)
+			hook(prev).m_next = item;
+		else
+			m_head = item;
+
+		if (next)
+			hook(next).m_prev = item;
+		else
+			m_tail = item;
+
+		m_size++;
+	}
+
+	template <typename T, intrusive_list_hook<T> T::* Hook>
+	void intrusive_list<T, Hook>::unlink(T* item)
+	{
+		intrusive_list_hook<T>& itemHook = hook(item);
+
+		if (itemHook.m_prev)
+			hook(itemHook.m_prev).m_next = itemHook.m_next;
+		else
+			m_head = itemHook.m_next;
+
+		if (itemHook.m_next)
+			hook(itemHook.m_next).m_prev = itemHook.m_prev;
+		else
+			m_tail = itemHook.m_prev;
+
+		itemHook.m_prev = nullptr;
+		itemHook.m_next = nullptr;
+
+		m_size--;
+	}
+}
\ No newline at end of file
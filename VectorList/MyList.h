@@ -1,9 +1,28 @@
 #pragma once
 
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 #include "SpyAllocator.h"
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define LIST_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#define LIST_PREFETCH(address) __builtin_prefetch(address)
+#endif
+
 namespace my
 {
+	// Lists smaller than this are likely already in cache, prefetching would only cost instructions
+	#define LIST_PREFETCH_MIN_SIZE 4096
+	// Nodes allocated at once when copying a list
+	#define LIST_COPY_CHUNK_SIZE 4096
+
 	template <typename T, class Allocator = SpyAllocator<T>>
 	class list
 	{
@@ -35,14 +54,41 @@ namespace my
 			T&				operator*();
 			T*				operator->();
 
-		private:
+		protected:
 			Node*	m_node;
 		};
 
 		typedef const_iterator iterator;
 
+		// Owns a node extracted from a list until it is inserted in another one.
+		// The element is neither moved nor copied and the node isn't reallocated on the way.
+		class node_type
+		{
+			friend list;
+
+		public:
+			node_type();
+			node_type(const node_type& other) = delete;
+			node_type(node_type&& other) noexcept;
+			~node_type();
+
+			node_type&	operator=(const node_type& other) = delete;
+			node_type&	operator=(node_type&& other) noexcept;
+
+			bool		empty() const;
+			explicit	operator bool() const;
+
+			T&			value() const;
+
+		private:
+			explicit node_type(Node* node);
+
+			Node*	m_node;
+		};
+
 		list();
 		list(const list& other);
+		list(const list& other, size_t workerCount);
 		list(list&& other) noexcept;
 		~list();
 
@@ -71,13 +117,25 @@ namespace my
 
 		iterator		insert(const_iterator it, const T& item);
 		iterator		insert(const const_iterator it, const size_t count, const T& item);
-		template		<typename U>
+		template		<typename U, typename = typename std::iterator_traits<U>::iterator_category>
 		iterator		insert(const_iterator it, U first, U last);
+		iterator		insert(const_iterator it, node_type&& node);
+
+		node_type		extract(const_iterator it);
 
 		void			remove(const T& val);
+		template		<typename Pred>
+		void			remove_if(Pred pred);
+
+		void			unique();
+		template		<typename Pred>
+		void			unique(Pred pred);
+
 		void			clear();
 
 	private:
+		class Chunk;
+
 		class Node
 		{
 			friend	list;
@@ -97,20 +155,54 @@ namespace my
 			Node& operator=(Node&& other) noexcept;
 
 		private:
-			T		m_data;
+			// Links first, iterating only ever touches the first cache line of a node whatever the size of T
 			Node*	m_prev;
 			Node*	m_next;
+			Chunk*	m_chunk; // The batch this node was allocated with, nullptr if allocated alone
+			T		m_data;
+		};
+
+		// Nodes allocated together by a batch insert, the chunk sits at the start of the same block.
+		// The block can only be given back once every node in it is destroyed.
+		class Chunk
+		{
+			friend	list;
+		public:
+			explicit Chunk(size_t count);
+
+		private:
+			size_t	m_count;
+			size_t	m_liveCount;
 		};
 
 		typedef typename Allocator::template rebind<Node>::other NodeAllocator;
+
+		// Node slots taken by the chunk in front of the nodes of a batch
+		static constexpr size_t	chunkHeaderSize = (sizeof(Chunk) + sizeof(Node) - 1) / sizeof(Node);
 		
 		Node*	m_head;
 		Node*	m_tail;
 		size_t	m_size;
 
-		void	removeNode(Node* node);
+		template		<typename U>
+		iterator		insertRange(const_iterator it, U first, U last, std::input_iterator_tag);
+		template		<typename U>
+		iterator		insertRange(const_iterator it, U first, U last, std::forward_iterator_tag);
+
+		void	copyFrom(const list& other, size_t workerCount);
+		static void	copyNodes(Node* nodes, size_t count, Chunk* chunk, const Node* source);
+
+		Node*	allocateNodes(size_t count, Chunk*& chunk);
+		static void	discardNodes(Node* nodes, size_t constructed, Chunk* chunk);
+		void	linkChain(Node* next, Node* first, Node* last, size_t count);
+		static void	freeNode(Node* node);
+		void	freeChain(Node* first);
+		void	unlinkNode(Node* node);
 	};
 
+	template <typename T, class Allocator>
+	constexpr size_t list<T, Allocator>::chunkHeaderSize;
+
 	template <typename T, class Allocator>
 	list<T, Allocator>::const_iterator::const_iterator() = default;
 
@@ -208,21 +300,80 @@ namespace my
 		return &m_node->m_data;
 	}
 
+	template <typename T, class Allocator>
+	list<T, Allocator>::node_type::node_type() : m_node(nullptr)
+	{
+	}
+
+	template <typename T, class Allocator>
+	list<T, Allocator>::node_type::node_type(Node* node) : m_node(node)
+	{
+	}
+
+	template <typename T, class Allocator>
+	list<T, Allocator>::node_type::node_type(node_type&& other) noexcept : m_node(other.m_node)
+	{
+		other.m_node = nullptr;
+	}
+
+	template <typename T, class Allocator>
+	list<T, Allocator>::node_type::~node_type()
+	{
+		// A node that never made it into another list still belongs to its chunk
+		if (m_node)
+			freeNode(m_node);
+	}
+
+	template <typename T, class Allocator>
+	typename list<T, Allocator>::node_type& list<T, Allocator>::node_type::operator=(node_type&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		if (m_node)
+			freeNode(m_node);
+
+		m_node = other.m_node;
+		other.m_node = nullptr;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	bool list<T, Allocator>::node_type::empty() const
+	{
+		return m_node == nullptr;
+	}
+
+	template <typename T, class Allocator>
+	list<T, Allocator>::node_type::operator bool() const
+	{
+		return m_node != nullptr;
+	}
+
+	template <typename T, class Allocator>
+	T& list<T, Allocator>::node_type::value() const
+	{
+		if (m_node == nullptr)
+			throw std::out_of_range("Empty node handle");
+
+		return m_node->m_data;
+	}
+
 	template <typename T, class Allocator>
 	list<T, Allocator>::list(): m_head(nullptr), m_tail(nullptr), m_size(0)
 	{
 	}
 
 	template <typename T, class Allocator>
-	list<T, Allocator>::list(const list& other)
+	list<T, Allocator>::list(const list& other) : list(other, 1)
 	{
-		// Necessary to be able to use push_back
-		m_head = nullptr;
-		m_tail = nullptr;
-		m_size = 0;
+	}
 
-		for (const_iterator i = other.begin(); i != other.end(); ++i)
-			push_back(*i);
+	template <typename T, class Allocator>
+	list<T, Allocator>::list(const list& other, const size_t workerCount) : m_head(nullptr), m_tail(nullptr), m_size(0)
+	{
+		copyFrom(other, workerCount);
 	}
 
 	template <typename T, class Allocator>
@@ -249,9 +400,7 @@ namespace my
 			return *this;
 
 		clear();
-
-		for (iterator i = other.begin(); i != other.end(); ++i)
-			push_back(*i);
+		copyFrom(other, 1);
 
 		return *this;
 	}
@@ -428,43 +577,169 @@ namespace my
 		if (count == 0)
 			return it;
 
-		iterator result = insert(it, item);
+		if (count == 1)
+			return insert(it, item);
+
+		NodeAllocator	nodeAllocator;
+		Chunk*			chunk;
 
-		for (size_t i = 1; i < count; i++)
-			insert(it, item);
+		Node* nodes = allocateNodes(count, chunk);
 
-		return result;
+		size_t i = 0;
+
+		// Build a detached chain first to link it in the list at once
+		try
+		{
+			for (; i < count; i++)
+			{
+				nodeAllocator.construct(&nodes[i], item, i > 0 ? &nodes[i - 1] : nullptr, nullptr);
+				nodes[i].m_chunk = chunk;
+
+				if (i > 0)
+					nodes[i - 1].m_next = &nodes[i];
+			}
+		}
+		catch (...)
+		{
+			discardNodes(nodes, i, chunk);
+			throw;
+		}
+
+		linkChain(it.m_node, &nodes[0], &nodes[count - 1], count);
+
+		return iterator(&nodes[0]);
 	}
 
 	template <typename T, class Allocator>
-	template <typename U>
+	template <typename U, typename>
 	typename list<T, Allocator>::iterator list<T, Allocator>::insert(const const_iterator it, U first, U last)
 	{
 		if (first == last)
 			return it;
 
-		iterator result = insert(it, *first++);
+		return insertRange(it, first, last, typename std::iterator_traits<U>::iterator_category());
+	}
 
-		for (U item = first; item != last; ++item)
-			insert(it, *item);
+	template <typename T, class Allocator>
+	typename list<T, Allocator>::iterator list<T, Allocator>::insert(const const_iterator it, node_type&& node)
+	{
+		Node* inserted = node.m_node;
 
-		return result;
+		if (inserted == nullptr)
+			return iterator(it.m_node);
+
+		node.m_node = nullptr;
+		linkChain(it.m_node, inserted, inserted, 1);
+
+		return iterator(inserted);
+	}
+
+	template <typename T, class Allocator>
+	typename list<T, Allocator>::node_type list<T, Allocator>::extract(const const_iterator it)
+	{
+		if (it.m_node == nullptr)
+			throw std::out_of_range("Can't extract the end of the list");
+
+		unlinkNode(it.m_node);
+
+		return node_type(it.m_node);
 	}
 
 	template <typename T, class Allocator>
 	void list<T, Allocator>::remove(const T& val)
 	{
-		Node* node = m_head;
+		remove_if([&val](const T& item) { return val == item; });
+	}
 
-		while (node)
+	template <typename T, class Allocator>
+	template <typename Pred>
+	void list<T, Allocator>::remove_if(Pred pred)
+	{
+		const bool	prefetch = m_size >= LIST_PREFETCH_MIN_SIZE;
+		Node*		removed = nullptr; // Chained through m_next, freed once the pass is over
+		Node*		node = m_head;
+
+		try
 		{
-			Node* next = node->m_next;
+			while (node)
+			{
+				Node* next = node->m_next;
 
-			if (val == node->m_data)
-				removeNode(node);
+				// Start loading the next node while the predicate looks at this one
+				if (prefetch && next)
+					LIST_PREFETCH(next);
 
-			node = next;
+				if (pred(node->m_data))
+				{
+					unlinkNode(node);
+
+					node->m_next = removed;
+					removed = node;
+				}
+
+				node = next;
+			}
+		}
+		catch (...)
+		{
+			// The nodes removed so far are already out of the list
+			freeChain(removed);
+			throw;
+		}
+
+		freeChain(removed);
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::unique()
+	{
+		unique(std::equal_to<T>());
+	}
+
+	template <typename T, class Allocator>
+	template <typename Pred>
+	void list<T, Allocator>::unique(Pred pred)
+	{
+		if (m_head == nullptr)
+			return;
+
+		const bool	prefetch = m_size >= LIST_PREFETCH_MIN_SIZE;
+		Node*		removed = nullptr;
+		Node*		kept = m_head;
+		Node*		node = kept->m_next;
+
+		try
+		{
+			// Each node is compared with the last one kept, like std::list::unique
+			while (node)
+			{
+				Node* next = node->m_next;
+
+				if (prefetch && next)
+					LIST_PREFETCH(next);
+
+				if (pred(kept->m_data, node->m_data))
+				{
+					unlinkNode(node);
+
+					node->m_next = removed;
+					removed = node;
+				}
+				else
+				{
+					kept = node;
+				}
+
+				node = next;
+			}
+		}
+		catch (...)
+		{
+			freeChain(removed);
+			throw;
 		}
+
+		freeChain(removed);
 	}
 
 	template <typename T, class Allocator>
@@ -475,29 +750,89 @@ namespace my
 
 		Node* node = m_head;
 
+		// Every node goes away, no need to keep the links or the size up to date on the way
 		while (node)
 		{
 			Node* next = node->m_next;
 
-			removeNode(node);
+			freeNode(node);
 
 			node = next;
 		}
+
+		m_head = m_tail = nullptr;
+		m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	template <typename U>
+	typename list<T, Allocator>::iterator list<T, Allocator>::insertRange(const const_iterator it, U first, U last,
+		std::input_iterator_tag)
+	{
+		// Single pass iterators can't be counted beforehand, insert them one by one
+		iterator result = insert(it, *first++);
+
+		for (U item = first; item != last; ++item)
+			insert(it, *item);
+
+		return result;
+	}
+
+	template <typename T, class Allocator>
+	template <typename U>
+	typename list<T, Allocator>::iterator list<T, Allocator>::insertRange(const const_iterator it, U first, U last,
+		std::forward_iterator_tag)
+	{
+		size_t count = 0;
+
+		for (U item = first; item != last; ++item)
+			count++;
+
+		NodeAllocator	nodeAllocator;
+		Chunk*			chunk;
+
+		Node* nodes = allocateNodes(count, chunk);
+
+		size_t i = 0;
+
+		try
+		{
+			for (U item = first; item != last; ++item, i++)
+			{
+				nodeAllocator.construct(&nodes[i], *item, i > 0 ? &nodes[i - 1] : nullptr, nullptr);
+				nodes[i].m_chunk = chunk;
+
+				if (i > 0)
+					nodes[i - 1].m_next = &nodes[i];
+			}
+		}
+		catch (...)
+		{
+			discardNodes(nodes, i, chunk);
+			throw;
+		}
+
+		linkChain(it.m_node, &nodes[0], &nodes[count - 1], count);
+
+		return iterator(&nodes[0]);
 	}
 
 	template <typename T, class Allocator>
-	list<T, Allocator>::Node::Node(const T& data, Node* prev, Node* next): m_data(data), m_prev(prev), m_next(next)
+	list<T, Allocator>::Node::Node(const T& data, Node* prev, Node* next):
+		m_prev(prev), m_next(next), m_chunk(nullptr), m_data(data)
 	{
 	}
 
 	template <typename T, class Allocator>
-	list<T, Allocator>::Node::Node(T&& data, Node* prev, Node* next): m_data(std::move(data)), m_prev(prev), m_next(next)
+	list<T, Allocator>::Node::Node(T&& data, Node* prev, Node* next):
+		m_prev(prev), m_next(next), m_chunk(nullptr), m_data(std::move(data))
 	{
 	}
 
 	template <typename T, class Allocator>
 	template <typename ... Args>
-	list<T, Allocator>::Node::Node(Node* prev, Node* next, Args... args): m_data(args...), m_prev(prev), m_next(next)
+	list<T, Allocator>::Node::Node(Node* prev, Node* next, Args... args):
+		m_prev(prev), m_next(next), m_chunk(nullptr), m_data(args...)
 	{
 	}
 
@@ -563,11 +898,223 @@ namespace my
 	}
 
 	template <typename T, class Allocator>
-	void list<T, Allocator>::removeNode(Node* node)
+	list<T, Allocator>::Chunk::Chunk(const size_t count):
+		m_count(count), m_liveCount(count)
+	{
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::copyFrom(const list& other, size_t workerCount)
+	{
+		const Node* source = other.m_head;
+
+		// Only plain copies run on the workers, a copy constructor could allocate or throw on another thread
+		if (workerCount <= 1 || other.m_size < workerCount || !std::is_trivially_copyable<T>::value)
+		{
+			try
+			{
+				for (size_t copied = 0, count; copied < other.m_size; copied += count)
+				{
+					count = other.m_size - copied < LIST_COPY_CHUNK_SIZE ? other.m_size - copied
+						: LIST_COPY_CHUNK_SIZE;
+
+					Chunk* chunk;
+					Node* nodes = allocateNodes(count, chunk);
+
+					copyNodes(nodes, count, chunk, source);
+					linkChain(nullptr, &nodes[0], &nodes[count - 1], count);
+
+					for (size_t i = 0; i < count; i++)
+						source = source->m_next;
+				}
+			}
+			catch (...)
+			{
+				// The chunks copied so far, a throwing constructor never runs the destructor
+				clear();
+				throw;
+			}
+
+			return;
+		}
+
+		// One chunk per worker, all allocated before any worker starts so that the allocator is only ever used
+		// from this thread, copying T never touches it
+		const size_t chunkSize = (other.m_size + workerCount - 1) / workerCount;
+		const size_t chunkCount = (other.m_size + chunkSize - 1) / chunkSize;
+
+		std::vector<Node*>			chunkNodes;
+		std::vector<Chunk*>			chunks;
+		std::vector<size_t>			chunkCounts;
+		std::vector<std::thread>	workers;
+
+		chunkNodes.reserve(chunkCount);
+		chunks.reserve(chunkCount);
+		chunkCounts.reserve(chunkCount);
+		workers.reserve(chunkCount);
+
+		try
+		{
+			for (size_t copied = 0; copied < other.m_size; copied += chunkSize)
+			{
+				const size_t count = other.m_size - copied < chunkSize ? other.m_size - copied : chunkSize;
+
+				Chunk* chunk;
+				chunkNodes.push_back(allocateNodes(count, chunk));
+				chunks.push_back(chunk);
+				chunkCounts.push_back(count);
+			}
+
+			for (size_t i = 0; i < chunkCount; i++)
+			{
+				workers.emplace_back(&list::copyNodes, chunkNodes[i], chunkCounts[i], chunks[i], source);
+
+				// Only the links are read to find where the next worker starts
+				for (size_t j = 0; j < chunkCounts[i]; j++)
+					source = source->m_next;
+			}
+		}
+		catch (...)
+		{
+			// Nothing is linked yet, the chunks of the workers that started are fully built once they are joined
+			for (std::thread& worker : workers)
+				worker.join();
+
+			for (size_t i = 0; i < chunkNodes.size(); i++)
+				discardNodes(chunkNodes[i], i < workers.size() ? chunkCounts[i] : 0, chunks[i]);
+
+			throw;
+		}
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		for (size_t i = 0; i < chunkCount; i++)
+			linkChain(nullptr, &chunkNodes[i][0], &chunkNodes[i][chunkCounts[i] - 1], chunkCounts[i]);
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::copyNodes(Node* nodes, const size_t count, Chunk* chunk, const Node* source)
+	{
+		NodeAllocator	nodeAllocator;
+		size_t			i = 0;
+
+		// Linked to each other only, linkChain attaches the whole chain to the list
+		try
+		{
+			for (; i < count; i++)
+			{
+				nodeAllocator.construct(&nodes[i], source->m_data, i > 0 ? &nodes[i - 1] : nullptr,
+					i + 1 < count ? &nodes[i + 1] : nullptr);
+				nodes[i].m_chunk = chunk;
+
+				source = source->m_next;
+			}
+		}
+		catch (...)
+		{
+			discardNodes(nodes, i, chunk);
+			throw;
+		}
+	}
+
+	template <typename T, class Allocator>
+	typename list<T, Allocator>::Node* list<T, Allocator>::allocateNodes(const size_t count, Chunk*& chunk)
+	{
+		if (count == 1)
+		{
+			chunk = nullptr;
+			return NodeAllocator().allocate(1);
+		}
+
+		static_assert(alignof(Node) % alignof(Chunk) == 0, "The chunk must be aligned at the start of a node block");
+
+		// One allocator round trip for the whole batch, its bookkeeping included
+		Node* block = NodeAllocator().allocate(chunkHeaderSize + count);
+
+		chunk = new (block) Chunk(count);
+
+		return block + chunkHeaderSize;
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::discardNodes(Node* nodes, const size_t constructed, Chunk* chunk)
+	{
+		// A batch that failed to build, none of its nodes were linked yet
+		for (size_t i = 0; i < constructed; i++)
+			nodes[i].~Node();
+
+		if (chunk == nullptr)
+		{
+			NodeAllocator().deallocate(nodes, 1);
+			return;
+		}
+
+		const size_t count = chunk->m_count;
+
+		chunk->~Chunk();
+		NodeAllocator().deallocate(nodes - chunkHeaderSize, chunkHeaderSize + count);
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::linkChain(Node* next, Node* first, Node* last, const size_t count)
 	{
-		if (node == nullptr)
+		Node* prev = next ? next->m_prev : m_tail;
+
+		first->m_prev = prev;
+		last->m_next = next;
+
+		if (prev)
+			prev->m_next = first;
+		else
+			m_head = first;
+
+		if (next)
+			next->m_prev = last;
+		else
+			m_tail = last;
+
+		m_size += count;
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::freeNode(Node* node)
+	{
+		Chunk* chunk = node->m_chunk;
+
+		node->~Node();
+
+		if (chunk == nullptr)
+		{
+			NodeAllocator().deallocate(node, 1);
+			return;
+		}
+
+		if (--chunk->m_liveCount > 0)
 			return;
 
+		const size_t count = chunk->m_count;
+
+		chunk->~Chunk();
+		NodeAllocator().deallocate(reinterpret_cast<Node*>(chunk), chunkHeaderSize + count);
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::freeChain(Node* first)
+	{
+		while (first)
+		{
+			Node* next = first->m_next;
+
+			freeNode(first);
+
+			first = next;
+		}
+	}
+
+	template <typename T, class Allocator>
+	void list<T, Allocator>::unlinkNode(Node* node)
+	{
 		if (node->m_prev)
 			node->m_prev->m_next = node->m_next;
 
@@ -580,9 +1127,6 @@ namespace my
 		if (node == m_tail)
 			m_tail = node->m_prev;
 
-		node->~Node();
-		NodeAllocator().deallocate(node, 1);
-
 		m_size--;
 	}
-}
+}
\ No newline at end of file
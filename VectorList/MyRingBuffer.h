@@ -0,0 +1,485 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "SpyAllocator.h"
+
+namespace my
+{
+	enum class ring_buffer_mode
+	{
+		overwrite,	// A push on a full buffer drops the oldest element
+		reject		// A push on a full buffer fails
+	};
+
+	// A fixed capacity circular buffer, the capacity is rounded up to a power of two to wrap indices with a mask.
+	// Index 0 is the oldest element.
+	template <typename T, class Allocator = SpyAllocator<T>>
+	class ring_buffer
+	{
+	public:
+		// The elements as at most two contiguous parts, oldest first
+		struct span_pair
+		{
+			T*		first;
+			size_t	firstSize;
+			T*		second;
+			size_t	secondSize;
+		};
+
+		explicit ring_buffer(size_t capacity, ring_buffer_mode mode = ring_buffer_mode::overwrite);
+		ring_buffer(const ring_buffer& other);
+		ring_buffer(ring_buffer&& other) noexcept;
+		~ring_buffer();
+
+		ring_buffer&	operator=(const ring_buffer& other);
+		ring_buffer&	operator=(ring_buffer&& other) noexcept;
+
+		T&				operator[](size_t i);
+		const T&		operator[](size_t i) const;
+
+		T&				front();
+		T&				back();
+
+		const T&		front() const;
+		const T&		back() const;
+
+		size_t			size() const;
+		size_t			capacity() const;
+		bool			empty() const;
+		bool			full() const;
+		ring_buffer_mode	mode() const;
+
+		bool			push_back(const T& item);
+		bool			push_back(T&& item);
+
+		template		<typename... Args>
+		bool			emplace_back(Args... args);
+
+		size_t			push_back(const T* items, size_t count);
+
+		void			pop_front();
+		size_t			pop_front(T* items, size_t count);
+
+		span_pair		spans() const;
+		void			consume(size_t count);
+
+		void			reserve(size_t capacity);
+		void			clear();
+
+	private:
+		T*					m_items;
+		size_t				m_mask;
+		size_t				m_head;
+		size_t				m_size;
+		ring_buffer_mode	m_mode;
+
+		static size_t	roundCapacity(size_t capacity);
+		bool			makeRoom();
+		bool			isOverwritten(const T& item) const;
+		bool			isStored(const T* items, size_t count) const;
+		void			appendItems(const T* items, size_t count);
+		void			setCapacity(size_t capacity);
+	};
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>::ring_buffer(const size_t capacity, const ring_buffer_mode mode) :
+		m_items(nullptr), m_mask(0), m_head(0), m_size(0), m_mode(mode)
+	{
+		setCapacity(roundCapacity(capacity));
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>::ring_buffer(const ring_buffer& other) :
+		m_items(other.m_items != nullptr ? Allocator().allocate(other.capacity()) : nullptr), m_mask(other.m_mask),
+		m_head(0), m_size(0), m_mode(other.m_mode)
+	{
+		const span_pair parts = other.spans();
+
+		// Copied unwrapped, starting at the beginning of the storage
+		try
+		{
+			appendItems(parts.first, parts.firstSize);
+			appendItems(parts.second, parts.secondSize);
+		}
+		catch (...)
+		{
+			// No destructor for a constructor that throws
+			clear();
+
+			if (m_items != nullptr)
+				Allocator().deallocate(m_items, capacity());
+
+			throw;
+		}
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>::ring_buffer(ring_buffer&& other) noexcept :
+		m_items(other.m_items), m_mask(other.m_mask), m_head(other.m_head), m_size(other.m_size), m_mode(other.m_mode)
+	{
+		other.m_items = nullptr;
+		other.m_mask = 0;
+		other.m_head = other.m_size = 0;
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>::~ring_buffer()
+	{
+		clear();
+
+		if (m_items != nullptr)
+			Allocator().deallocate(m_items, capacity());
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>& ring_buffer<T, Allocator>::operator=(const ring_buffer& other)
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+
+		if (capacity() != other.capacity())
+			setCapacity(other.capacity());
+
+		const span_pair parts = other.spans();
+
+		m_head = 0;
+		m_mode = other.m_mode;
+
+		appendItems(parts.first, parts.firstSize);
+		appendItems(parts.second, parts.secondSize);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer<T, Allocator>& ring_buffer<T, Allocator>::operator=(ring_buffer&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		clear();
+
+		if (m_items != nullptr)
+			Allocator().deallocate(m_items, capacity());
+
+		m_items = other.m_items;
+		m_mask = other.m_mask;
+		m_head = other.m_head;
+		m_size = other.m_size;
+		m_mode = other.m_mode;
+
+		other.m_items = nullptr;
+		other.m_mask = 0;
+		other.m_head = other.m_size = 0;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	T& ring_buffer<T, Allocator>::operator[](const size_t i)
+	{
+		return m_items[(m_head + i) & m_mask];
+	}
+
+	template <typename T, class Allocator>
+	const T& ring_buffer<T, Allocator>::operator[](const size_t i) const
+	{
+		return m_items[(m_head + i) & m_mask];
+	}
+
+	template <typename T, class Allocator>
+	T& ring_buffer<T, Allocator>::front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty ring buffer");
+
+		return m_items[m_head];
+	}
+
+	template <typename T, class Allocator>
+	T& ring_buffer<T, Allocator>::back()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty ring buffer");
+
+		return (*this)[m_size - 1];
+	}
+
+	template <typename T, class Allocator>
+	const T& ring_buffer<T, Allocator>::front() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty ring buffer");
+
+		return m_items[m_head];
+	}
+
+	template <typename T, class Allocator>
+	const T& ring_buffer<T, Allocator>::back() const
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty ring buffer");
+
+		return (*this)[m_size - 1];
+	}
+
+	template <typename T, class Allocator>
+	size_t ring_buffer<T, Allocator>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename T, class Allocator>
+	size_t ring_buffer<T, Allocator>::capacity() const
+	{
+		return m_items != nullptr ? m_mask + 1 : 0;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::empty() const
+	{
+		return m_size == 0;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::full() const
+	{
+		return m_size == capacity();
+	}
+
+	template <typename T, class Allocator>
+	ring_buffer_mode ring_buffer<T, Allocator>::mode() const
+	{
+		return m_mode;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::push_back(const T& item)
+	{
+		// Copied aside before makeRoom destroys it
+		if (isOverwritten(item))
+			return push_back(T(item));
+
+		if (!makeRoom())
+			return false;
+
+		new (&m_items[(m_head + m_size) & m_mask]) T(item);
+		m_size++;
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::push_back(T&& item)
+	{
+		if (isOverwritten(item))
+		{
+			T moved(std::move(item));
+			return push_back(std::move(moved));
+		}
+
+		if (!makeRoom())
+			return false;
+
+		new (&m_items[(m_head + m_size) & m_mask]) T(std::move(item));
+		m_size++;
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	template <typename ... Args>
+	bool ring_buffer<T, Allocator>::emplace_back(Args... args)
+	{
+		if (!makeRoom())
+			return false;
+
+		new (&m_items[(m_head + m_size) & m_mask]) T(args...);
+		m_size++;
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	size_t ring_buffer<T, Allocator>::push_back(const T* items, size_t count)
+	{
+		const size_t capacity = this->capacity();
+
+		if (m_mode == ring_buffer_mode::reject)
+		{
+			if (count > capacity - m_size)
+				count = capacity - m_size;
+		}
+		else
+		{
+			// Only the newest items would survive anyway
+			if (count > capacity)
+			{
+				items += count - capacity;
+				count = capacity;
+			}
+
+			if (count > capacity - m_size)
+			{
+				// The oldest elements are destroyed to make room, the items might be some of them
+				if (isStored(items, count))
+				{
+					const std::vector<T, Allocator> copies(items, items + count);
+					return push_back(copies.data(), count);
+				}
+
+				consume(count - (capacity - m_size));
+			}
+		}
+
+		appendItems(items, count);
+
+		return count;
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::pop_front()
+	{
+		if (m_size == 0)
+			throw std::out_of_range("Empty ring buffer");
+
+		consume(1);
+	}
+
+	template <typename T, class Allocator>
+	size_t ring_buffer<T, Allocator>::pop_front(T* items, size_t count)
+	{
+		if (count > m_size)
+			count = m_size;
+
+		const size_t firstCount = std::min(count, capacity() - m_head);
+
+		std::move(m_items + m_head, m_items + m_head + firstCount, items);
+		std::move(m_items, m_items + count - firstCount, items + firstCount);
+
+		consume(count);
+
+		return count;
+	}
+
+	template <typename T, class Allocator>
+	typename ring_buffer<T, Allocator>::span_pair ring_buffer<T, Allocator>::spans() const
+	{
+		const size_t firstSize = std::min(m_size, capacity() - m_head);
+
+		return { m_items + m_head, firstSize, m_items, m_size - firstSize };
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::consume(size_t count)
+	{
+		if (count > m_size)
+			count = m_size;
+
+		for (size_t i = 0; i < count; i++)
+			m_items[(m_head + i) & m_mask].~T();
+
+		m_head = (m_head + count) & m_mask;
+		m_size -= count;
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::reserve(const size_t capacity)
+	{
+		if (capacity > this->capacity())
+			setCapacity(roundCapacity(capacity));
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::clear()
+	{
+		consume(m_size);
+		m_head = 0;
+	}
+
+	template <typename T, class Allocator>
+	size_t ring_buffer<T, Allocator>::roundCapacity(const size_t capacity)
+	{
+		size_t rounded = 1;
+
+		while (rounded < capacity)
+			rounded <<= 1;
+
+		return rounded;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::makeRoom()
+	{
+		if (m_size < capacity())
+			return true;
+
+		// A moved from buffer has no storage at all
+		if (m_mode == ring_buffer_mode::reject || m_size == 0)
+			return false;
+
+		consume(1);
+
+		return true;
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::isOverwritten(const T& item) const
+	{
+		// Pushing to a full buffer in overwrite mode drops the oldest element first
+		return m_mode == ring_buffer_mode::overwrite && m_size > 0 && m_size == capacity() && &item == &m_items[m_head];
+	}
+
+	template <typename T, class Allocator>
+	bool ring_buffer<T, Allocator>::isStored(const T* items, const size_t count) const
+	{
+		const std::less<const T*> less;
+
+		return count > 0 && m_items != nullptr && less(items, m_items + capacity()) && less(m_items, items + count);
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::appendItems(const T* items, const size_t count)
+	{
+		// The free space is at most two contiguous parts, the end of the storage then its beginning.
+		// Each part is counted once built, a throwing copy in the second one leaves the first to the destructor.
+		const size_t tail = (m_head + m_size) & m_mask;
+		const size_t firstCount = std::min(count, capacity() - tail);
+
+		std::uninitialized_copy(items, items + firstCount, m_items + tail);
+		m_size += firstCount;
+
+		std::uninitialized_copy(items + firstCount, items + count, m_items);
+		m_size += count - firstCount;
+	}
+
+	template <typename T, class Allocator>
+	void ring_buffer<T, Allocator>::setCapacity(const size_t capacity)
+	{
+		Allocator	allocator;
+		T*			items = capacity > 0 ? allocator.allocate(capacity) : nullptr;
+
+		if (m_items != nullptr)
+		{
+			// Unwrapped on the way, the oldest element lands at the beginning of the new storage
+			for (size_t i = 0; i < m_size; i++)
+				new (&items[i]) T(std::move((*this)[i]));
+
+			for (size_t i = 0; i < m_size; i++)
+				(*this)[i].~T();
+
+			allocator.deallocate(m_items, this->capacity());
+		}
+
+		m_items = items;
+		m_mask = capacity > 0 ? capacity - 1 : 0;
+		m_head = 0;
+	}
+}
\ No newline at end of file
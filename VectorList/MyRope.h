@@ -0,0 +1,688 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+
+#include "MyString.h"
+#include "MyStringView.h"
+#include "SpyAllocator.h"
+
+namespace my
+{
+	// Most characters held by a single leaf, adjacent leaves are merged on joins while they fit
+	#define ROPE_LEAF_SIZE 512
+
+	// Deepest tree the leaf iterator can walk, an AVL tree that high needs over 10^13 leaves
+	#define ROPE_MAX_HEIGHT 64
+
+	// A string stored as an AVL tree of basic_string leaves, for large texts edited in the middle.
+	// Insert, erase, substr and index are O(log n) and never move the characters of untouched leaves.
+	// Nodes are immutable and reference counted: a copy shares the whole tree, an edit copies the path it changes.
+	template <typename T = char, class Allocator = SpyAllocator<T>>
+	class basic_rope
+	{
+		class Node;
+
+	public:
+		class leaf_range;
+
+		static constexpr size_t	npos = static_cast<size_t>(-1);
+
+		basic_rope();
+		explicit basic_rope(const T* str);
+		explicit basic_rope(basic_string_view<T> str);
+		basic_rope(const basic_rope& other);
+		basic_rope(basic_rope&& other) noexcept;
+		~basic_rope();
+
+		basic_rope&		operator=(const basic_rope& other);
+		basic_rope&		operator=(basic_rope&& other) noexcept;
+
+		T				operator[](size_t index) const;
+
+		size_t			length() const;
+		size_t			size() const;
+		bool			empty() const;
+
+		basic_rope&		insert(size_t pos, basic_string_view<T> str);
+		basic_rope&		insert(size_t pos, const basic_rope& other);
+		basic_rope&		append(basic_string_view<T> str);
+		basic_rope&		append(const basic_rope& other);
+		basic_rope&		erase(size_t pos, size_t count = npos);
+		void			clear();
+
+		basic_rope		substr(size_t pos, size_t count = npos) const;
+
+		// The leaves in order, as views over their characters.
+		// The range is invalidated by any change to the rope.
+		leaf_range		leaves() const;
+
+		// Copy the characters into a single contiguous string
+		basic_string<T, Allocator>	flatten() const;
+
+	private:
+		class Node
+		{
+			friend	basic_rope;
+
+			Node(const T* str, size_t size);
+			Node(basic_string<T, Allocator>&& text);
+			Node(Node* left, Node* right);
+
+			bool	isLeaf() const;
+
+			std::atomic<size_t>			m_refCount;
+			Node*						m_left;
+			Node*						m_right;
+			basic_string<T, Allocator>	m_text; // Empty for inner nodes
+			size_t						m_size;
+			size_t						m_height; // Leaves are 1
+		};
+
+		typedef typename Allocator::template rebind<Node>::other NodeAllocator;
+
+		Node*	m_root;
+
+		explicit basic_rope(Node* root);
+
+		// Functions taking a Node* as a "part" adopt its reference, the ones returning a Node* hand one over
+		template <typename... Args>
+		static Node*	makeNode(Args&&... args);
+		static Node*	retain(Node* node);
+		static void		release(Node* node);
+
+		static size_t	sizeOf(const Node* node);
+
+		static Node*	build(const T* str, size_t size);
+		static Node*	join(Node* left, Node* right);
+		static Node*	balance(Node* left, Node* right);
+		static void		split(Node* node, size_t pos, Node*& left, Node*& right);
+	};
+
+	template <typename T, class Allocator>
+	class basic_rope<T, Allocator>::leaf_range
+	{
+		friend	basic_rope;
+
+	public:
+		class const_iterator : public std::iterator<std::forward_iterator_tag, basic_string_view<T>>
+		{
+			friend	leaf_range;
+
+		public:
+			const_iterator();
+
+			bool	operator==(const const_iterator& other) const;
+			bool	operator!=(const const_iterator& other) const;
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			basic_string_view<T>	operator*() const;
+
+		private:
+			explicit const_iterator(const Node* root);
+
+			void	descend(const Node* node);
+
+			const Node*	m_leaf;
+			const Node*	m_pending[ROPE_MAX_HEIGHT]; // Right subtrees still to visit, the next one on top
+			size_t		m_pendingCount;
+		};
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+	private:
+		explicit leaf_range(const Node* root);
+
+		const Node*	m_root;
+	};
+
+	using rope = basic_rope<char, SpyAllocator<char>>;
+
+	template <typename T, class Allocator>
+	constexpr size_t basic_rope<T, Allocator>::npos;
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope() : m_root(nullptr)
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope(const T* str) :
+		m_root(build(str, basic_string<T, Allocator>::stringLength(str)))
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope(const basic_string_view<T> str) : m_root(build(str.data(), str.size()))
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope(const basic_rope& other) : m_root(retain(other.m_root))
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope(basic_rope&& other) noexcept : m_root(other.m_root)
+	{
+		other.m_root = nullptr;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::basic_rope(Node* root) : m_root(root)
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::~basic_rope()
+	{
+		release(m_root);
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::operator=(const basic_rope& other)
+	{
+		// Retained first, the other rope might share this tree
+		Node* root = retain(other.m_root);
+
+		release(m_root);
+		m_root = root;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::operator=(basic_rope&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		release(m_root);
+
+		m_root = other.m_root;
+		other.m_root = nullptr;
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	T basic_rope<T, Allocator>::operator[](size_t index) const
+	{
+		if (index >= size())
+			throw std::out_of_range("Index out of range");
+
+		const Node* node = m_root;
+
+		while (!node->isLeaf())
+		{
+			const size_t leftSize = node->m_left->m_size;
+
+			if (index < leftSize)
+			{
+				node = node->m_left;
+			}
+			else
+			{
+				index -= leftSize;
+				node = node->m_right;
+			}
+		}
+
+		return node->m_text.c_str()[index];
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_rope<T, Allocator>::length() const
+	{
+		return size();
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_rope<T, Allocator>::size() const
+	{
+		return sizeOf(m_root);
+	}
+
+	template <typename T, class Allocator>
+	bool basic_rope<T, Allocator>::empty() const
+	{
+		return m_root == nullptr;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::insert(const size_t pos, const basic_string_view<T> str)
+	{
+		if (pos > size())
+			throw std::out_of_range("Index out of range");
+
+		Node* left;
+		Node* right;
+
+		split(m_root, pos, left, right);
+		release(m_root);
+
+		m_root = join(join(left, build(str.data(), str.size())), right);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::insert(const size_t pos, const basic_rope& other)
+	{
+		if (pos > size())
+			throw std::out_of_range("Index out of range");
+
+		// The inserted tree is shared, not copied
+		Node* inserted = retain(other.m_root);
+
+		Node* left;
+		Node* right;
+
+		split(m_root, pos, left, right);
+		release(m_root);
+
+		m_root = join(join(left, inserted), right);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::append(const basic_string_view<T> str)
+	{
+		m_root = join(m_root, build(str.data(), str.size()));
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::append(const basic_rope& other)
+	{
+		m_root = join(m_root, retain(other.m_root));
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>& basic_rope<T, Allocator>::erase(const size_t pos, size_t count)
+	{
+		const size_t size = this->size();
+
+		if (pos > size)
+			throw std::out_of_range("Index out of range");
+
+		count = std::min(count, size - pos);
+
+		if (count == 0)
+			return *this;
+
+		Node* left;
+		Node* rest;
+		Node* erased;
+		Node* right;
+
+		split(m_root, pos, left, rest);
+		split(rest, count, erased, right);
+
+		release(m_root);
+		release(rest);
+		release(erased);
+
+		m_root = join(left, right);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	void basic_rope<T, Allocator>::clear()
+	{
+		release(m_root);
+		m_root = nullptr;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator> basic_rope<T, Allocator>::substr(const size_t pos, size_t count) const
+	{
+		const size_t size = this->size();
+
+		if (pos > size)
+			throw std::out_of_range("Index out of range");
+
+		count = std::min(count, size - pos);
+
+		Node* left;
+		Node* rest;
+		Node* middle;
+		Node* right;
+
+		split(m_root, pos, left, rest);
+		split(rest, count, middle, right);
+
+		release(left);
+		release(rest);
+		release(right);
+
+		return basic_rope(middle);
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::leaf_range basic_rope<T, Allocator>::leaves() const
+	{
+		return leaf_range(m_root);
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator> basic_rope<T, Allocator>::flatten() const
+	{
+		basic_string<T, Allocator> result;
+		result.reserve(size());
+
+		for (const basic_string_view<T> leaf : leaves())
+			result.append(leaf.data(), leaf.size());
+
+		return result;
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::Node::Node(const T* str, const size_t size) :
+		m_refCount(1), m_left(nullptr), m_right(nullptr), m_text(str, size), m_size(size), m_height(1)
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::Node::Node(basic_string<T, Allocator>&& text) :
+		m_refCount(1), m_left(nullptr), m_right(nullptr), m_text(std::move(text)), m_size(m_text.size()),
+		m_height(1)
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::Node::Node(Node* left, Node* right) :
+		m_refCount(1), m_left(left), m_right(right), m_size(left->m_size + right->m_size),
+		m_height(std::max(left->m_height, right->m_height) + 1)
+	{
+	}
+
+	template <typename T, class Allocator>
+	bool basic_rope<T, Allocator>::Node::isLeaf() const
+	{
+		return m_left == nullptr;
+	}
+
+	template <typename T, class Allocator>
+	template <typename... Args>
+	typename basic_rope<T, Allocator>::Node* basic_rope<T, Allocator>::makeNode(Args&&... args)
+	{
+		Node* node = NodeAllocator().allocate(1);
+		new (node) Node(std::forward<Args>(args)...);
+
+		return node;
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::Node* basic_rope<T, Allocator>::retain(Node* node)
+	{
+		if (node != nullptr)
+			node->m_refCount.fetch_add(1, std::memory_order_relaxed);
+
+		return node;
+	}
+
+	template <typename T, class Allocator>
+	void basic_rope<T, Allocator>::release(Node* node)
+	{
+		if (node == nullptr || node->m_refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		release(node->m_left);
+		release(node->m_right);
+
+		node->~Node();
+		NodeAllocator().deallocate(node, 1);
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_rope<T, Allocator>::sizeOf(const Node* node)
+	{
+		return node != nullptr ? node->m_size : 0;
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::Node* basic_rope<T, Allocator>::build(const T* str, const size_t size)
+	{
+		if (size == 0)
+			return nullptr;
+
+		if (size <= ROPE_LEAF_SIZE)
+			return makeNode(str, size);
+
+		// Cut on a leaf boundary, halves of the same number of leaves give heights at most 1 apart
+		const size_t leafCount = (size + ROPE_LEAF_SIZE - 1) / ROPE_LEAF_SIZE;
+		const size_t leftSize = leafCount / 2 * ROPE_LEAF_SIZE;
+
+		return makeNode(build(str, leftSize), build(str + leftSize, size - leftSize));
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::Node* basic_rope<T, Allocator>::join(Node* left, Node* right)
+	{
+		if (left == nullptr)
+			return right;
+
+		if (right == nullptr)
+			return left;
+
+		// Small edits would otherwise leave a trail of tiny leaves
+		if (left->isLeaf() && right->isLeaf() && left->m_size + right->m_size <= ROPE_LEAF_SIZE)
+		{
+			Node* leaf = makeNode(left->m_text + right->m_text);
+
+			release(left);
+			release(right);
+
+			return leaf;
+		}
+
+		// The shorter tree is joined along the facing spine of the taller one, only that path is copied
+		if (left->m_height > right->m_height + 1)
+		{
+			Node* outer = retain(left->m_left);
+			Node* inner = join(retain(left->m_right), right);
+
+			release(left);
+
+			return balance(outer, inner);
+		}
+
+		if (right->m_height > left->m_height + 1)
+		{
+			Node* inner = join(left, retain(right->m_left));
+			Node* outer = retain(right->m_right);
+
+			release(right);
+
+			return balance(inner, outer);
+		}
+
+		return makeNode(left, right);
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::Node* basic_rope<T, Allocator>::balance(Node* left, Node* right)
+	{
+		// A join grows a subtree by at most one level, the heights are at most 2 apart here
+		if (right->m_height > left->m_height + 1)
+		{
+			Node* inner = right->m_left;
+
+			if (inner->m_height > right->m_right->m_height)
+			{
+				Node* newLeft = makeNode(left, retain(inner->m_left));
+				Node* newRight = makeNode(retain(inner->m_right), retain(right->m_right));
+
+				release(right);
+
+				return makeNode(newLeft, newRight);
+			}
+
+			Node* newLeft = makeNode(left, retain(inner));
+			Node* newRight = retain(right->m_right);
+
+			release(right);
+
+			return makeNode(newLeft, newRight);
+		}
+
+		if (left->m_height > right->m_height + 1)
+		{
+			Node* inner = left->m_right;
+
+			if (inner->m_height > left->m_left->m_height)
+			{
+				Node* newLeft = makeNode(retain(left->m_left), retain(inner->m_left));
+				Node* newRight = makeNode(retain(inner->m_right), right);
+
+				release(left);
+
+				return makeNode(newLeft, newRight);
+			}
+
+			Node* newLeft = retain(left->m_left);
+			Node* newRight = makeNode(retain(inner), right);
+
+			release(left);
+
+			return makeNode(newLeft, newRight);
+		}
+
+		return makeNode(left, right);
+	}
+
+	template <typename T, class Allocator>
+	void basic_rope<T, Allocator>::split(Node* node, const size_t pos, Node*& left, Node*& right)
+	{
+		// The node itself is only borrowed, both parts are new references
+		if (pos == 0)
+		{
+			left = nullptr;
+			right = retain(node);
+			return;
+		}
+
+		if (pos >= sizeOf(node))
+		{
+			left = retain(node);
+			right = nullptr;
+			return;
+		}
+
+		if (node->isLeaf())
+		{
+			const T* str = node->m_text.c_str();
+
+			left = makeNode(str, pos);
+			right = makeNode(str + pos, node->m_size - pos);
+			return;
+		}
+
+		const size_t leftSize = node->m_left->m_size;
+		Node* middle;
+
+		if (pos < leftSize)
+		{
+			split(node->m_left, pos, left, middle);
+			right = join(middle, retain(node->m_right));
+		}
+		else
+		{
+			split(node->m_right, pos - leftSize, middle, right);
+			left = join(retain(node->m_left), middle);
+		}
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::leaf_range::leaf_range(const Node* root) : m_root(root)
+	{
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::leaf_range::const_iterator basic_rope<T, Allocator>::leaf_range::begin() const
+	{
+		return const_iterator(m_root);
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::leaf_range::const_iterator basic_rope<T, Allocator>::leaf_range::end() const
+	{
+		return const_iterator();
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::leaf_range::const_iterator::const_iterator() : m_leaf(nullptr), m_pendingCount(0)
+	{
+	}
+
+	template <typename T, class Allocator>
+	basic_rope<T, Allocator>::leaf_range::const_iterator::const_iterator(const Node* root) :
+		m_leaf(nullptr), m_pendingCount(0)
+	{
+		if (root != nullptr)
+			descend(root);
+	}
+
+	template <typename T, class Allocator>
+	bool basic_rope<T, Allocator>::leaf_range::const_iterator::operator==(const const_iterator& other) const
+	{
+		return m_leaf == other.m_leaf;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_rope<T, Allocator>::leaf_range::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return m_leaf != other.m_leaf;
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::leaf_range::const_iterator&
+		basic_rope<T, Allocator>::leaf_range::const_iterator::operator++()
+	{
+		if (m_pendingCount == 0)
+			m_leaf = nullptr;
+		else
+			descend(m_pending[--m_pendingCount]);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	typename basic_rope<T, Allocator>::leaf_range::const_iterator
+		basic_rope<T, Allocator>::leaf_range::const_iterator::operator++(int)
+	{
+		const_iterator tmp(*this);
+		++*this;
+		return tmp;
+	}
+
+	template <typename T, class Allocator>
+	basic_string_view<T> basic_rope<T, Allocator>::leaf_range::const_iterator::operator*() const
+	{
+		return basic_string_view<T>(m_leaf->m_text.c_str(), m_leaf->m_size);
+	}
+
+	template <typename T, class Allocator>
+	void basic_rope<T, Allocator>::leaf_range::const_iterator::descend(const Node* node)
+	{
+		while (!node->isLeaf())
+		{
+			m_pending[m_pendingCount++] = node->m_right;
+			node = node->m_left;
+		}
+
+		m_leaf = node;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+
+#include "SpyAllocator.h"
+
+namespace my
+{
+	#define SKIP_LIST_MAX_HEIGHT 24
+
+	// An ordered set kept in a skip list.
+	// Readers (find, contains, iteration) never lock and can run while a writer inserts or erases.
+	// Writers are serialized by an internal mutex.
+	// Erased and cleared nodes stay allocated until collect() is called while no reader is active,
+	// or the list is destroyed.
+	template <typename T, class Compare = std::less<T>, class Allocator = SpyAllocator<T>>
+	class skip_list
+	{
+		class Node;
+	public:
+		class const_iterator : public std::iterator<std::forward_iterator_tag, T>
+		{
+			friend skip_list;
+
+		public:
+			const_iterator();
+			const_iterator(const Node* node);
+			const_iterator(const const_iterator& other);
+			const_iterator(const_iterator&& other) noexcept;
+			~const_iterator() = default;
+
+			const_iterator&	operator=(const const_iterator& other);
+			const_iterator&	operator=(const_iterator&& other) noexcept;
+
+			bool			operator==(const const_iterator& other) const;
+			bool			operator!=(const const_iterator& other) const;
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			const T&		operator*() const;
+			const T*		operator->() const;
+
+		private:
+			const Node*	m_node;
+		};
+
+		typedef const_iterator iterator;
+
+		skip_list();
+		skip_list(const skip_list& other) = delete;
+		~skip_list();
+
+		skip_list&		operator=(const skip_list& other) = delete;
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+		size_t			size() const;
+
+		bool			insert(const T& item);
+		bool			erase(const T& item);
+
+		const_iterator	find(const T& item) const;
+		bool			contains(const T& item) const;
+
+		void			collect();
+		void			clear();
+
+	private:
+		class Node
+		{
+			friend	skip_list;
+		public:
+			Node(const T& data, uint8_t height);
+
+		private:
+			T					m_data;
+			uint8_t				m_height;
+			Node*				m_nextRetired;
+			std::atomic<Node*>	m_next[1]; // The rest of the tower is allocated right after the node
+		};
+
+		typedef typename Allocator::template rebind<Node>::other NodeAllocator;
+
+		Node*				m_head;
+		Node*				m_retired;
+		std::atomic<size_t>	m_size;
+		std::mutex			m_writeMutex;
+		uint32_t			m_seed;
+
+		const Node*	findNode(const T& item) const;
+		Node*		findPredecessors(const T& item, Node** preds) const;
+		uint8_t		randomHeight();
+
+		static Node*	allocateNode(uint8_t height);
+		static void		freeNode(Node* node);
+		static size_t	nodeUnits(uint8_t height);
+		static bool		equals(const T& left, const T& right);
+	};
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::const_iterator::const_iterator() = default;
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::const_iterator::const_iterator(const Node* node)
+	{
+		m_node = node;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::const_iterator::const_iterator(const const_iterator& other) : m_node(other.m_node)
+	{
+	}
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::const_iterator::const_iterator(const_iterator&& other) noexcept : m_node(other.m_node)
+	{
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator& skip_list<T, Compare, Allocator>::const_iterator::operator=(
+		const const_iterator& other)
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_node = other.m_node;
+
+		return *this;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator& skip_list<T, Compare, Allocator>::const_iterator::operator=(
+		const_iterator&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		this->m_node = other.m_node;
+
+		return *this;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::const_iterator::operator==(const const_iterator& other) const
+	{
+		return other.m_node == m_node;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return other.m_node != m_node;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator& skip_list<T, Compare, Allocator>::const_iterator::operator++()
+	{
+		m_node = m_node->m_next[0].load(std::memory_order_acquire);
+		return *this;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator skip_list<T, Compare, Allocator>::const_iterator::operator++(int)
+	{
+		const_iterator tmp = *this;
+		m_node = m_node->m_next[0].load(std::memory_order_acquire);
+		return tmp;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	const T& skip_list<T, Compare, Allocator>::const_iterator::operator*() const
+	{
+		return m_node->m_data;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	const T* skip_list<T, Compare, Allocator>::const_iterator::operator->() const
+	{
+		return &m_node->m_data;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::skip_list() : m_retired(nullptr), m_size(0), m_seed(0x9E3779B9u)
+	{
+		// The head is a full height tower without any data
+		m_head = allocateNode(SKIP_LIST_MAX_HEIGHT);
+
+		for (uint8_t i = 0; i < SKIP_LIST_MAX_HEIGHT; i++)
+			new (&m_head->m_next[i]) std::atomic<Node*>(nullptr);
+	}
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::~skip_list()
+	{
+		clear();
+		collect();
+
+		NodeAllocator().deallocate(m_head, nodeUnits(SKIP_LIST_MAX_HEIGHT));
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator skip_list<T, Compare, Allocator>::begin() const
+	{
+		return const_iterator(m_head->m_next[0].load(std::memory_order_acquire));
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator skip_list<T, Compare, Allocator>::end() const
+	{
+		return const_iterator(nullptr);
+	}
+
+	template <typename T, class Compare, class Allocator>
+	size_t skip_list<T, Compare, Allocator>::size() const
+	{
+		return m_size.load(std::memory_order_relaxed);
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::insert(const T& item)
+	{
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+
+		Node* preds[SKIP_LIST_MAX_HEIGHT];
+		Node* next = findPredecessors(item, preds);
+
+		if (next != nullptr && equals(next->m_data, item))
+			return false;
+
+		const uint8_t height = randomHeight();
+
+		Node* node = allocateNode(height);
+		new (node) Node(item, height);
+
+		for (uint8_t i = 0; i < height; i++)
+			new (&node->m_next[i]) std::atomic<Node*>(preds[i]->m_next[i].load(std::memory_order_relaxed));
+
+		// Publish bottom-up: a reader seeing the node on a level can always go down from there
+		for (uint8_t i = 0; i < height; i++)
+			preds[i]->m_next[i].store(node, std::memory_order_release);
+
+		m_size.fetch_add(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::erase(const T& item)
+	{
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+
+		Node* preds[SKIP_LIST_MAX_HEIGHT];
+		Node* node = findPredecessors(item, preds);
+
+		if (node == nullptr || !equals(node->m_data, item))
+			return false;
+
+		// Unlink top-down, the node keeps its own links so readers standing on it can move on
+		for (uint8_t i = node->m_height; i-- > 0;)
+			preds[i]->m_next[i].store(node->m_next[i].load(std::memory_order_relaxed), std::memory_order_release);
+
+		node->m_nextRetired = m_retired;
+		m_retired = node;
+
+		m_size.fetch_sub(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::const_iterator skip_list<T, Compare, Allocator>::find(const T& item) const
+	{
+		return const_iterator(findNode(item));
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::contains(const T& item) const
+	{
+		return findNode(item) != nullptr;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	void skip_list<T, Compare, Allocator>::collect()
+	{
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+
+		while (m_retired)
+		{
+			Node* next = m_retired->m_nextRetired;
+
+			freeNode(m_retired);
+
+			m_retired = next;
+		}
+	}
+
+	template <typename T, class Compare, class Allocator>
+	void skip_list<T, Compare, Allocator>::clear()
+	{
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+
+		Node* node = m_head->m_next[0].load(std::memory_order_relaxed);
+
+		// Detached top-down like an erase, readers already inside the chain can still walk it to the end
+		for (uint8_t i = SKIP_LIST_MAX_HEIGHT; i-- > 0;)
+			m_head->m_next[i].store(nullptr, std::memory_order_release);
+
+		while (node)
+		{
+			Node* next = node->m_next[0].load(std::memory_order_relaxed);
+
+			node->m_nextRetired = m_retired;
+			m_retired = node;
+
+			node = next;
+		}
+
+		m_size.store(0, std::memory_order_relaxed);
+	}
+
+	template <typename T, class Compare, class Allocator>
+	skip_list<T, Compare, Allocator>::Node::Node(const T& data, const uint8_t height) :
+		m_data(data), m_height(height), m_nextRetired(nullptr)
+	{
+	}
+
+	template <typename T, class Compare, class Allocator>
+	const typename skip_list<T, Compare, Allocator>::Node* skip_list<T, Compare, Allocator>::findNode(const T& item) const
+	{
+		const Node* node = m_head;
+
+		for (uint8_t i = SKIP_LIST_MAX_HEIGHT; i-- > 0;)
+		{
+			const Node* next = node->m_next[i].load(std::memory_order_acquire);
+
+			while (next != nullptr && Compare()(next->m_data, item))
+			{
+				node = next;
+				next = node->m_next[i].load(std::memory_order_acquire);
+			}
+
+			if (next != nullptr && !Compare()(item, next->m_data))
+				return next;
+		}
+
+		return nullptr;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::Node* skip_list<T, Compare, Allocator>::findPredecessors(const T& item,
+		Node** preds) const
+	{
+		Node* node = m_head;
+		Node* next = nullptr;
+
+		for (uint8_t i = SKIP_LIST_MAX_HEIGHT; i-- > 0;)
+		{
+			next = node->m_next[i].load(std::memory_order_acquire);
+
+			while (next != nullptr && Compare()(next->m_data, item))
+			{
+				node = next;
+				next = node->m_next[i].load(std::memory_order_acquire);
+			}
+
+			preds[i] = node;
+		}
+
+		// First node not lower than the item on the bottom level
+		return next;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	uint8_t skip_list<T, Compare, Allocator>::randomHeight()
+	{
+		// Xorshift, only called by the writer holding the lock
+		m_seed ^= m_seed << 13;
+		m_seed ^= m_seed >> 17;
+		m_seed ^= m_seed << 5;
+
+		// Each level has half the nodes of the one below
+		uint8_t		height = 1;
+		uint32_t	bits = m_seed;
+
+		while ((bits & 1) != 0 && height < SKIP_LIST_MAX_HEIGHT)
+		{
+			height++;
+			bits >>= 1;
+		}
+
+		return height;
+	}
+
+	template <typename T, class Compare, class Allocator>
+	typename skip_list<T, Compare, Allocator>::Node* skip_list<T, Compare, Allocator>::allocateNode(const uint8_t height)
+	{
+		return NodeAllocator().allocate(nodeUnits(height));
+	}
+
+	template <typename T, class Compare, class Allocator>
+	void skip_list<T, Compare, Allocator>::freeNode(Node* node)
+	{
+		const uint8_t height = node->m_height;
+
+		node->~Node();
+		NodeAllocator().deallocate(node, nodeUnits(height));
+	}
+
+	template <typename T, class Compare, class Allocator>
+	size_t skip_list<T, Compare, Allocator>::nodeUnits(const uint8_t height)
+	{
+		// The node holds the first link, the tower takes as many extra node sized units as needed
+		const size_t towerSize = (height - 1) * sizeof(std::atomic<Node*>);
+
+		return 1 + (towerSize + sizeof(Node) - 1) / sizeof(Node);
+	}
+
+	template <typename T, class Compare, class Allocator>
+	bool skip_list<T, Compare, Allocator>::equals(const T& left, const T& right)
+	{
+		return !Compare()(left, right) && !Compare()(right, left);
+	}
+}
\ No newline at end of file
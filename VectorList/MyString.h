@@ -1,14 +1,50 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include "SpyAllocator.h"
+#include "MyStringView.h"
+#include "StringSearch.h"
+#include "StringSimd.h"
 
 namespace my
 {
-	#define SSO_BUFFER_SIZE 16
 	#define CAPACITY_STEP 16
 
+	// Growth factor applied to the capacity when appending past it
+	#define STRING_GROWTH_NUMERATOR 3
+	#define STRING_GROWTH_DENOMINATOR 2
+
+	// Set to 0 to deep copy heap strings instead of sharing their block until one copy is written to
+	#define STRING_COPY_ON_WRITE 1
+
+	// Set to 0 to hash heap strings on every call instead of keeping their hash next to the characters
+	#define STRING_CACHE_HASH 1
+
+	#define STRING_BLOCK_HEADER (STRING_COPY_ON_WRITE || STRING_CACHE_HASH)
+
+	// The string is the size of three pointers, 24 bytes on x64.
+	// A short string is stored in place and the last byte of the object holds its remaining inline capacity,
+	// that byte doubles as the terminator once the inline buffer is full.
+	// A long string sets the high bit of that same byte, which is the top bit of its capacity on little-endian targets.
+	// With STRING_COPY_ON_WRITE, copies of a long string share its block, any mutable access detaches the copy first.
+	// With STRING_CACHE_HASH, the block of a long string also keeps its hash until the next mutable access.
+	// Once a mutable pointer, reference or iterator was handed out, the block is never shared nor its hash cached again,
+	// the caller may write through it at any time.
+	template <typename T, class Allocator>
+	class basic_string;
+
+	// Concatenate strings, C strings and characters with a single allocation for the result,
+	// e.g. concat(date, " [", level, "] ", message, '\n')
+	template <typename T = char, class Allocator = SpyAllocator<T>, typename... Pieces>
+	basic_string<T, Allocator>	concat(const Pieces&... pieces);
+
 	template <typename T = char, class Allocator = SpyAllocator<T>>
 	class basic_string
 	{
@@ -49,8 +85,11 @@ namespace my
 
 		typedef const_iterator iterator;
 
+		static constexpr size_t	npos = static_cast<size_t>(-1);
+
 		basic_string();
 		basic_string(const T* str);
+		basic_string(const T* str, size_t size);
 		basic_string(const basic_string& other);
 		basic_string(basic_string&& other) noexcept;
 		~basic_string();
@@ -59,15 +98,45 @@ namespace my
 		basic_string&	operator=(const basic_string& other);
 		basic_string&	operator=(basic_string&& other) noexcept;
 
+		basic_string&	assign(const T* str);
+		basic_string&	assign(const T* str, size_t size);
+		basic_string&	assign(const basic_string& other);
+
 		T				operator[](size_t index) const;
 		T&				operator[](size_t index);
 
-		basic_string	operator+(const basic_string& other) const;
-		basic_string	operator+(const T* str) const;
+		bool			operator==(const basic_string& other) const;
+		bool			operator!=(const basic_string& other) const;
+
+		// The view is invalidated by any change to the string
+		operator		basic_string_view<T>() const;
+
+		basic_string	operator+(const basic_string& other) const &;
+		basic_string	operator+(const T* str) const &;
+
+		// A temporary on the left, as in a + b + c, is appended to in place
+		basic_string	operator+(const basic_string& other) &&;
+		basic_string	operator+(const T* str) &&;
+
+		basic_string&	operator+=(const basic_string& other);
+		basic_string&	operator+=(const T* str);
+		basic_string&	operator+=(T ch);
+
+		basic_string&	append(const basic_string& other);
+		basic_string&	append(const T* str, size_t count);
+		basic_string&	append(size_t count, T ch);
+		void			push_back(T ch);
 
 		size_t			length() const;
 		size_t			size() const;
+		size_t			capacity() const;
+		bool			empty() const;
+
+		basic_string_view<T>	substr_view(size_t pos, size_t count = npos) const;
+
 		const T*		c_str() const;
+		const T*		data() const;
+		T*				data();
 
 		iterator		begin();
 		iterator		end();
@@ -75,26 +144,110 @@ namespace my
 		const_iterator	begin() const;
 		const_iterator	end() const;
 
+		void			reserve(size_t capacity);
+		void			resize(size_t size, T ch = static_cast<T>(0));
+		void			shrink_to_fit();
 		void			clear();
 
+		size_t			find(const basic_string& str, size_t pos = 0) const;
+		size_t			find(const T* str, size_t pos = 0) const;
+		size_t			find(T ch, size_t pos = 0) const;
+
+		size_t			rfind(const basic_string& str, size_t pos = npos) const;
+		size_t			rfind(const T* str, size_t pos = npos) const;
+		size_t			rfind(T ch, size_t pos = npos) const;
+
+		size_t			find_first_of(const basic_string& chars, size_t pos = 0) const;
+		size_t			find_first_of(const T* chars, size_t pos = 0) const;
+
+		size_t			find_last_not_of(const basic_string& chars, size_t pos = npos) const;
+		size_t			find_last_not_of(const T* chars, size_t pos = npos) const;
+
+		bool			starts_with(const basic_string& prefix) const;
+		bool			starts_with(const T* prefix) const;
+		bool			starts_with(T ch) const;
+
+		bool			ends_with(const basic_string& suffix) const;
+		bool			ends_with(const T* suffix) const;
+		bool			ends_with(T ch) const;
+
+		bool			contains(const basic_string& str) const;
+		bool			contains(const T* str) const;
+		bool			contains(T ch) const;
+
+		// Equal to the hash of a basic_string_view over the same characters
+		size_t			hash() const;
+
 		static size_t	stringLength(const T* str);
 
 	private:
+		template <typename U, class UAllocator, typename... Pieces>
+		friend basic_string<U, UAllocator>	concat(const Pieces&... pieces);
+
+		struct long_layout
+		{
+			T*		m_str;
+			size_t	m_size;
+			size_t	m_capacity; // Allocated elements, the top bit flags a long string
+		};
+
+		static_assert(sizeof(long_layout) % sizeof(T) == 0, "The character type must fit evenly in the string layout");
+
+		// In front of the characters of a heap block
+		struct shared_header
+		{
+#if STRING_COPY_ON_WRITE
+			std::atomic<unsigned int>	m_refCount{ 1 };
+#endif
+			bool						m_unshareable{ false }; // Set for good by the non-const data()
+#if STRING_CACHE_HASH
+			std::atomic<size_t>			m_hash{ 0 }; // 0 until computed, a hash of 0 is simply never cached
+#endif
+		};
+
+		// Elements reserved for the header at the start of every heap block
+		static constexpr size_t	headerSize = STRING_BLOCK_HEADER
+			? (sizeof(shared_header) + sizeof(T) - 1) / sizeof(T) : 0;
+
+		// The last element of the inline buffer is reserved for the terminator
+		static constexpr size_t	smallCapacity = sizeof(long_layout) / sizeof(T) - 1;
+		static constexpr size_t	longFlag = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 1);
+
 		union
 		{
-			T*	m_str;
-			T	m_small_str_buffer[SSO_BUFFER_SIZE];
-		}; // Using a union to save memory since these members won't ever be used together
-		size_t	m_size;
-		size_t	m_capacity;
-
-		void	setCapacity(size_t capacity);
-		size_t	calculateCapacity(size_t size) const;
-		bool	isSmallString() const;
+			long_layout	m_long;
+			T			m_small_str_buffer[smallCapacity + 1];
+		};
+
+		bool			isSmallString() const;
+		unsigned char	tagByte() const;
+		unsigned char&	tagByte();
+		size_t			allocatedSize() const;
+		bool			isShared() const;
+		bool			isUnshareable() const;
+		void			detach();
+		void			forgetHash();
+
+		T*				writableData();
+		void			setSize(size_t size);
+		void			setSmallSize(size_t size);
+		T*				initialize(size_t size);
+		void			reallocate(size_t allocated, const T* extra = nullptr, size_t extraCount = 0);
+		void			release();
+
+		static T*		allocateBlock(size_t allocated);
+		static void		freeBlock(T* str, size_t allocated);
+		static shared_header*	headerOf(T* str);
+
+		size_t			growCapacity(size_t size) const;
+		static size_t	calculateCapacity(size_t size);
 	};
 
 	using string = basic_string<char, SpyAllocator<char>>;
 
+	template <typename T, class Allocator>
+	constexpr size_t basic_string<T, Allocator>::npos;
+
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::const_iterator::const_iterator() = default;
 
@@ -220,104 +373,64 @@ namespace my
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::basic_string()
-		: m_str(nullptr), m_size(0), m_capacity(0)
 	{
-		// Set every element of the small string buffer to it's equivalent of 0
-		for (T& i : m_small_str_buffer)
-			i = static_cast<T>(0);
+		setSmallSize(0);
 	}
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::basic_string(const T* str)
 	{
-		m_size = stringLength(str);
-		m_capacity = 0;
-		m_str = nullptr;
+		const size_t size = stringLength(str);
 
-		if (!isSmallString())
-		{
-			setCapacity(calculateCapacity(m_size));
-
-			for (size_t i = 0; i < m_size; i++)
-				new (&m_str[i]) T(str[i]);
-		}
-		else
-		{
-			memcpy_s(m_small_str_buffer, m_size * sizeof(T),
-				str, (m_size) * sizeof(T));
+		memcpy_s(initialize(size), size * sizeof(T), str, size * sizeof(T));
+	}
 
-			for (size_t i = m_size; i < SSO_BUFFER_SIZE; i++)
-				m_small_str_buffer[i] = static_cast<T>(0);
-		}
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>::basic_string(const T* str, const size_t size)
+	{
+		memcpy_s(initialize(size), size * sizeof(T), str, size * sizeof(T));
 	}
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::basic_string(const basic_string& other)
 	{
-		m_size = other.m_size;
-		m_capacity = 0;
-		m_str = nullptr;
-
-		if (isSmallString())
+#if STRING_COPY_ON_WRITE
+		if (!other.isSmallString() && !other.isUnshareable())
 		{
-			memcpy_s(m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T),
-			         other.m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T));
+			memcpy_s(&m_long, sizeof(long_layout), &other.m_long, sizeof(long_layout));
+			headerOf(m_long.m_str)->m_refCount.fetch_add(1, std::memory_order_relaxed);
+			return;
 		}
-		else
-		{
-			setCapacity(calculateCapacity(m_size));
+#endif
 
-			for (size_t i = 0; i < m_size; i++)
-				new (&m_str[i]) T(other.m_str[i]);
-		}
+		const size_t size = other.size();
+
+		memcpy_s(initialize(size), size * sizeof(T), other.data(), size * sizeof(T));
 	}
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::basic_string(basic_string&& other) noexcept
 	{
-		m_size = other.m_size;
-		m_capacity = other.m_capacity;
-		m_str = other.m_str;
+		// Whatever the mode, the whole representation is taken as is
+		memcpy_s(&m_long, sizeof(long_layout), &other.m_long, sizeof(long_layout));
 
-		if (isSmallString())
-			memcpy_s(m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T),
-				other.m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T));
-
-		other.m_size = 0;
-		other.m_str = nullptr;
+		other.setSmallSize(0);
 	}
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>::~basic_string()
 	{
-		setCapacity(0);
+		if (!isSmallString())
+			freeBlock(m_long.m_str, allocatedSize());
 	}
 
 	template <typename T, class Allocator>
 	basic_string<T, Allocator>& basic_string<T, Allocator>::operator=(const T* str)
 	{
-		if (str == m_str)
+		if (str == c_str())
 			return *this;
 
-		clear();
-
-		m_size = stringLength(str);
-
-		if (isSmallString())
-		{
-			for (size_t i = 0; i < SSO_BUFFER_SIZE; i++)
-				new (&m_small_str_buffer[i]) T(i < m_size ? str[i] 
-					: static_cast<T>(0));
-		}
-		else
-		{
-			setCapacity(calculateCapacity(m_size));
-
-			for (size_t i = 0; i < m_size; i++)
-				new (&m_str[i]) T(str[i]);
-		}
-
-		return *this;
+		return assign(str, stringLength(str));
 	}
 
 	template <typename T, class Allocator>
@@ -326,24 +439,19 @@ namespace my
 		if (this == &other)
 			return *this;
 
-		clear();
-
-		m_size = other.m_size;
-
-		if (isSmallString())
+#if STRING_COPY_ON_WRITE
+		if (!other.isSmallString() && !other.isUnshareable())
 		{
-			memcpy_s(m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T),
-			         other.m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T));
-		}
-		else
-		{
-			setCapacity(calculateCapacity(m_size));
+			// Shared first, this string might be the last other owner of the block
+			headerOf(other.m_long.m_str)->m_refCount.fetch_add(1, std::memory_order_relaxed);
+			release();
 
-			for (size_t i = 0; i < m_size; i++)
-				new (&m_str[i]) T(other.m_str[i]);
+			memcpy_s(&m_long, sizeof(long_layout), &other.m_long, sizeof(long_layout));
+			return *this;
 		}
+#endif
 
-		return *this;
+		return assign(other.data(), other.size());
 	}
 
 	template <typename T, class Allocator>
@@ -352,214 +460,694 @@ namespace my
 		if (this == &other)
 			return *this;
 
-		clear();
+		release();
 
-		m_size = other.m_size;
-		m_capacity = other.m_capacity;
-		m_str = other.m_str;
+		memcpy_s(&m_long, sizeof(long_layout), &other.m_long, sizeof(long_layout));
 
-		if (isSmallString())
-			memcpy_s(m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T),
-				other.m_small_str_buffer, SSO_BUFFER_SIZE * sizeof(T));
+		other.setSmallSize(0);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::assign(const T* str)
+	{
+		return assign(str, stringLength(str));
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::assign(const T* str, const size_t size)
+	{
+		if (size > capacity() || isShared())
+		{
+			// The current characters are overwritten anyway, nothing to move to the new block.
+			// A shared block stays alive with its other owners, str may still point into it.
+			release();
+			memcpy_s(initialize(size), size * sizeof(T), str, size * sizeof(T));
+			return *this;
+		}
 
-		other.m_size = 0;
-		other.m_str = nullptr;
+		// The source might be a part of this string
+		std::memmove(writableData(), str, size * sizeof(T));
+		setSize(size);
 
 		return *this;
 	}
 
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::assign(const basic_string& other)
+	{
+		return assign(other.data(), other.size());
+	}
+
 	template <typename T, class Allocator>
 	T basic_string<T, Allocator>::operator[](size_t index) const
 	{
-		if (index >= m_size)
+		if (index >= size())
 			throw std::out_of_range("Index out of range");
 
-		if (isSmallString())
-			return m_small_str_buffer[index];
-
-		return m_str[index];
+		return data()[index];
 	}
 
 	template <typename T, class Allocator>
 	T& basic_string<T, Allocator>::operator[](size_t index)
 	{
-		if (index >= m_size)
+		if (index >= size())
 			throw std::out_of_range("Index out of range");
 
-		if (isSmallString())
-			return m_small_str_buffer[index];
+		return data()[index];
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::operator==(const basic_string& other) const
+	{
+		const size_t size = this->size();
+
+		if (size != other.size())
+			return false;
 
-		return m_str[index];
+		if (!isSmallString() && !other.isSmallString())
+		{
+			// Copies sharing a block are equal without reading it
+			if (m_long.m_str == other.m_long.m_str)
+				return true;
+
+#if STRING_CACHE_HASH
+			// Only blocks never handed out for writing keep a hash, a cached one is current
+			const size_t hash = headerOf(m_long.m_str)->m_hash.load(std::memory_order_relaxed);
+			const size_t otherHash = headerOf(other.m_long.m_str)->m_hash.load(std::memory_order_relaxed);
+
+			if (hash != 0 && otherHash != 0 && hash != otherHash)
+				return false;
+#endif
+		}
+
+		return std::memcmp(data(), other.data(), size * sizeof(T)) == 0;
 	}
 
 	template <typename T, class Allocator>
-	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const basic_string& other) const
+	bool basic_string<T, Allocator>::operator!=(const basic_string& other) const
 	{
-		const size_t totalSize = m_size + other.m_size;
+		return !(*this == other);
+	}
 
-		basic_string result;
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>::operator basic_string_view<T>() const
+	{
+		return basic_string_view<T>(data(), size());
+	}
 
-		result.setCapacity(result.calculateCapacity(totalSize));
-		result.m_size = totalSize;
+	template <typename T, class Allocator>
+	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const basic_string& other) const &
+	{
+		const size_t size = this->size();
+		const size_t otherSize = other.size();
 
-		for (size_t i = 0; i < result.m_size; i++)
-			result[i] = i < m_size ? (*this)[i] : other[i - m_size];
+		basic_string result;
+		T* str = result.initialize(size + otherSize);
+
+		memcpy_s(str, size * sizeof(T), data(), size * sizeof(T));
+		memcpy_s(str + size, otherSize * sizeof(T), other.data(), otherSize * sizeof(T));
 
 		return result;
 	}
 
 	template <typename T, class Allocator>
-	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const T* str) const
+	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const T* str) const &
 	{
-		const size_t strLen = stringLength(str);  
-		const size_t totalSize = m_size + strLen;
+		const size_t size = this->size();
+		const size_t strLen = stringLength(str);
 
 		basic_string result;
+		T* resultStr = result.initialize(size + strLen);
 
-		result.setCapacity(calculateCapacity(totalSize));
-		result.m_size = totalSize;
-
-		for (size_t i = 0; i < totalSize; i++)
-			result[i] = i < m_size ? (*this)[i] : str[i - m_size];
+		memcpy_s(resultStr, size * sizeof(T), data(), size * sizeof(T));
+		memcpy_s(resultStr + size, strLen * sizeof(T), str, strLen * sizeof(T));
 
 		return result;
 	}
 
+	template <typename T, class Allocator>
+	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const basic_string& other) &&
+	{
+		append(other);
+		return std::move(*this);
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator> basic_string<T, Allocator>::operator+(const T* str) &&
+	{
+		append(str, stringLength(str));
+		return std::move(*this);
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::operator+=(const basic_string& other)
+	{
+		return append(other);
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::operator+=(const T* str)
+	{
+		return append(str, stringLength(str));
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::operator+=(const T ch)
+	{
+		push_back(ch);
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::append(const basic_string& other)
+	{
+		return append(other.data(), other.size());
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::append(const T* str, const size_t count)
+	{
+		const size_t size = this->size();
+
+		if (count > capacity() - size)
+		{
+			// The appended characters might live in the current storage, they are copied before it is released
+			reallocate(growCapacity(size + count), str, count);
+			return *this;
+		}
+
+		std::memmove(writableData() + size, str, count * sizeof(T));
+		setSize(size + count);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	basic_string<T, Allocator>& basic_string<T, Allocator>::append(const size_t count, const T ch)
+	{
+		const size_t size = this->size();
+
+		if (count > capacity() - size)
+			reallocate(growCapacity(size + count));
+
+		std::fill_n(writableData() + size, count, ch);
+		setSize(size + count);
+
+		return *this;
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::push_back(const T ch)
+	{
+		append(&ch, 1);
+	}
+
 	template <typename T, class Allocator>
 	size_t basic_string<T, Allocator>::length() const
 	{
-		return m_size;
+		return size();
 	}
 
 	template <typename T, class Allocator>
 	size_t basic_string<T, Allocator>::size() const
 	{
-		return m_size;
+		if (isSmallString())
+			return smallCapacity - tagByte();
+
+		return m_long.m_size;
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::capacity() const
+	{
+		if (isSmallString())
+			return smallCapacity;
+
+		return allocatedSize() - 1;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename T, class Allocator>
+	basic_string_view<T> basic_string<T, Allocator>::substr_view(const size_t pos, const size_t count) const
+	{
+		return basic_string_view<T>(data(), size()).substr(pos, count);
 	}
 
 	template <typename T, class Allocator>
 	const T* basic_string<T, Allocator>::c_str() const
 	{
-		return m_str;
+		return data();
 	}
 
 	template <typename T, class Allocator>
-	typename basic_string<T, Allocator>::iterator basic_string<T, Allocator>::begin()
+	const T* basic_string<T, Allocator>::data() const
 	{
 		if (isSmallString())
-			return iterator(&m_small_str_buffer[0]);
+			return m_small_str_buffer;
 
-		return iterator(m_str);
+		return m_long.m_str;
 	}
 
 	template <typename T, class Allocator>
-	typename basic_string<T, Allocator>::iterator basic_string<T, Allocator>::end()
+	T* basic_string<T, Allocator>::data()
 	{
-		if (isSmallString())
-			return iterator(&m_small_str_buffer[m_size]);
+		T* str = writableData();
+
+#if STRING_BLOCK_HEADER
+		// The caller might write through the pointer long after this call, copies can't share the block anymore
+		if (!isSmallString())
+			headerOf(str)->m_unshareable = true;
+#endif
 
-		return iterator(m_str + m_size);
+		return str;
 	}
 
 	template <typename T, class Allocator>
-	typename basic_string<T, Allocator>::const_iterator basic_string<T, Allocator>::begin() const
+	typename basic_string<T, Allocator>::iterator basic_string<T, Allocator>::begin()
 	{
-		if (isSmallString())
-			return const_iterator(&m_small_str_buffer[0]);
+		return iterator(data());
+	}
+
+	template <typename T, class Allocator>
+	typename basic_string<T, Allocator>::iterator basic_string<T, Allocator>::end()
+	{
+		return iterator(data() + size());
+	}
 
-		return const_iterator(m_str);
+	template <typename T, class Allocator>
+	typename basic_string<T, Allocator>::const_iterator basic_string<T, Allocator>::begin() const
+	{
+		return const_iterator(const_cast<T*>(data()));
 	}
 
 	template <typename T, class Allocator>
 	typename basic_string<T, Allocator>::const_iterator basic_string<T, Allocator>::end() const
+	{
+		return const_iterator(const_cast<T*>(data()) + size());
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::reserve(const size_t capacity)
+	{
+		if (capacity <= this->capacity())
+			return;
+
+		reallocate(calculateCapacity(capacity));
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::resize(const size_t size, const T ch)
+	{
+		const size_t currentSize = this->size();
+
+		if (size > currentSize)
+			append(size - currentSize, ch);
+		else
+			setSize(size);
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::shrink_to_fit()
 	{
 		if (isSmallString())
-			return const_iterator(&m_small_str_buffer[m_size]);
-		
-		return const_iterator(m_str + m_size);
+			return;
+
+		const size_t size = m_long.m_size;
+
+		if (size > smallCapacity)
+		{
+			if (calculateCapacity(size) < allocatedSize())
+				reallocate(calculateCapacity(size));
+
+			return;
+		}
+
+		// Back in place, the block is read before the inline buffer overwrites the pointer to it
+		T* str = m_long.m_str;
+		const size_t allocated = allocatedSize();
+
+		memcpy_s(m_small_str_buffer, size * sizeof(T), str, size * sizeof(T));
+		setSmallSize(size);
+
+		freeBlock(str, allocated);
 	}
 
 	template <typename T, class Allocator>
 	void basic_string<T, Allocator>::clear()
 	{
-		if (!isSmallString())
-			for (size_t i = 0; i < m_size; i++)
-				m_str[i].~T();
+		// No point in copying a shared block to empty it
+		if (isShared())
+			release();
+		else
+			setSize(0);
+	}
 
-		m_size = 0;
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find(const basic_string& str, const size_t pos) const
+	{
+		return detail::findSubstring(data(), size(), str.data(), str.size(), pos);
 	}
 
 	template <typename T, class Allocator>
-	size_t basic_string<T, Allocator>::stringLength(const T* str)
+	size_t basic_string<T, Allocator>::find(const T* str, const size_t pos) const
 	{
-		size_t size = 0;
+		return detail::findSubstring(data(), size(), str, stringLength(str), pos);
+	}
 
-		if (str != nullptr)
-			for (size_t i = 0; str[i] != static_cast<T>(0); i++)
-				size++;
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find(const T ch, const size_t pos) const
+	{
+		return detail::findSubstring(data(), size(), &ch, 1, pos);
+	}
 
-		return size;
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::rfind(const basic_string& str, const size_t pos) const
+	{
+		return detail::rfindSubstring(data(), size(), str.data(), str.size(), pos);
 	}
 
 	template <typename T, class Allocator>
-	void basic_string<T, Allocator>::setCapacity(const size_t capacity)
+	size_t basic_string<T, Allocator>::rfind(const T* str, const size_t pos) const
 	{
-		if (capacity == m_capacity)
-			return;
+		return detail::rfindSubstring(data(), size(), str, stringLength(str), pos);
+	}
 
-		Allocator	allocator;
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::rfind(const T ch, const size_t pos) const
+	{
+		return detail::rfindSubstring(data(), size(), &ch, 1, pos);
+	}
 
-		if (capacity < m_capacity)
-		{
-			if (isSmallString())
-				for (size_t i = capacity; i < m_size; i++)
-					m_small_str_buffer[i].~T();
-			else
-				for (size_t i = capacity; i < m_size; i++)
-					m_str[i].~T();
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find_first_of(const basic_string& chars, const size_t pos) const
+	{
+		return detail::findFirstOf(data(), size(), chars.data(), chars.size(), pos);
+	}
 
-			if (capacity < m_size)
-				m_size -= m_size - capacity;
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find_first_of(const T* chars, const size_t pos) const
+	{
+		return detail::findFirstOf(data(), size(), chars, stringLength(chars), pos);
+	}
 
-			allocator.deallocate(m_str + capacity, m_capacity - capacity);
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find_last_not_of(const basic_string& chars, const size_t pos) const
+	{
+		return detail::findLastNotOf(data(), size(), chars.data(), chars.size(), pos);
+	}
 
-			if (capacity == 0)
-				m_str = nullptr;
-		}
-		else if (capacity > SSO_BUFFER_SIZE)
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::find_last_not_of(const T* chars, const size_t pos) const
+	{
+		return detail::findLastNotOf(data(), size(), chars, stringLength(chars), pos);
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::starts_with(const basic_string& prefix) const
+	{
+		return detail::startsWith(data(), size(), prefix.data(), prefix.size());
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::starts_with(const T* prefix) const
+	{
+		return detail::startsWith(data(), size(), prefix, stringLength(prefix));
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::starts_with(const T ch) const
+	{
+		return !empty() && data()[0] == ch;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::ends_with(const basic_string& suffix) const
+	{
+		return detail::endsWith(data(), size(), suffix.data(), suffix.size());
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::ends_with(const T* suffix) const
+	{
+		return detail::endsWith(data(), size(), suffix, stringLength(suffix));
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::ends_with(const T ch) const
+	{
+		return !empty() && data()[size() - 1] == ch;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::contains(const basic_string& str) const
+	{
+		return find(str) != npos;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::contains(const T* str) const
+	{
+		return find(str) != npos;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::contains(const T ch) const
+	{
+		return find(ch) != npos;
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::stringLength(const T* str)
+	{
+		if (str == nullptr)
+			return 0;
+
+		return simd::stringLength(str);
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::hash() const
+	{
+#if STRING_CACHE_HASH
+		// Short strings are hashed in a handful of cycles and have no room for the hash anyway.
+		// Characters handed out for writing may change behind the string's back, their hash is never kept.
+		if (!isSmallString() && !isUnshareable())
 		{
-			T* str = allocator.allocate(capacity);
+			std::atomic<size_t>& cached = headerOf(m_long.m_str)->m_hash;
+			size_t hash = cached.load(std::memory_order_relaxed);
 
-			if (m_str != nullptr)
+			// Threads sharing the block may compute it at the same time, they all store the same value
+			if (hash == 0)
 			{
-				for (size_t i = 0; i < m_size; i++)
-				{
-					new (&str[i]) T(std::move(m_str[i]));
-					m_str[i].~T();
-				}
-
-				allocator.deallocate(m_str, m_capacity);
+				hash = basic_string_view<T>(m_long.m_str, m_long.m_size).hash();
+				cached.store(hash, std::memory_order_relaxed);
 			}
 
-			for (size_t i = m_size; i < capacity; i++)
-				str[i] = static_cast<T>(0);
+			return hash;
+		}
+#endif
+
+		return basic_string_view<T>(data(), size()).hash();
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::isSmallString() const
+	{
+		return (tagByte() & 0x80) == 0;
+	}
+
+	template <typename T, class Allocator>
+	unsigned char basic_string<T, Allocator>::tagByte() const
+	{
+		return reinterpret_cast<const unsigned char*>(&m_long)[sizeof(long_layout) - 1];
+	}
+
+	template <typename T, class Allocator>
+	unsigned char& basic_string<T, Allocator>::tagByte()
+	{
+		return reinterpret_cast<unsigned char*>(&m_long)[sizeof(long_layout) - 1];
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::allocatedSize() const
+	{
+		return m_long.m_capacity & ~longFlag;
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::isShared() const
+	{
+#if STRING_COPY_ON_WRITE
+		return !isSmallString() && headerOf(m_long.m_str)->m_refCount.load(std::memory_order_acquire) > 1;
+#else
+		return false;
+#endif
+	}
+
+	template <typename T, class Allocator>
+	bool basic_string<T, Allocator>::isUnshareable() const
+	{
+#if STRING_BLOCK_HEADER
+		return !isSmallString() && headerOf(m_long.m_str)->m_unshareable;
+#else
+		return false;
+#endif
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::detach()
+	{
+		if (isShared())
+			reallocate(allocatedSize());
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::forgetHash()
+	{
+#if STRING_CACHE_HASH
+		if (!isSmallString())
+			headerOf(m_long.m_str)->m_hash.store(0, std::memory_order_relaxed);
+#endif
+	}
+
+	template <typename T, class Allocator>
+	T* basic_string<T, Allocator>::writableData()
+	{
+		if (isSmallString())
+			return m_small_str_buffer;
 
-			m_str = str;
+		// About to be written to
+		detach();
+		forgetHash();
+
+		return m_long.m_str;
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::setSize(const size_t size)
+	{
+		if (isSmallString())
+		{
+			setSmallSize(size);
+			return;
 		}
 
-		m_capacity = capacity;
+		detach();
+		forgetHash();
+
+		m_long.m_size = size;
+		m_long.m_str[size] = static_cast<T>(0);
 	}
 
 	template <typename T, class Allocator>
-	size_t basic_string<T, Allocator>::calculateCapacity(size_t size) const
+	void basic_string<T, Allocator>::setSmallSize(const size_t size)
 	{
-		size++; // Add 1 to the size for the \0
+		// A full buffer writes its terminator over the tag, which is then 0 as well
+		m_small_str_buffer[size] = static_cast<T>(0);
+		tagByte() = static_cast<unsigned char>(smallCapacity - size);
+	}
 
-		if (m_capacity >= size)
-			return m_capacity;
+	template <typename T, class Allocator>
+	T* basic_string<T, Allocator>::initialize(const size_t size)
+	{
+		// Any heap block must have been released by the caller
+		if (size <= smallCapacity)
+		{
+			setSmallSize(size);
+			return m_small_str_buffer;
+		}
 
-		if (size <= SSO_BUFFER_SIZE)
-			return 0;
+		const size_t allocated = calculateCapacity(size);
+
+		m_long.m_str = allocateBlock(allocated);
+		m_long.m_size = size;
+		m_long.m_capacity = allocated | longFlag;
+		m_long.m_str[size] = static_cast<T>(0);
+
+		return m_long.m_str;
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::reallocate(const size_t allocated, const T* extra, const size_t extraCount)
+	{
+		// A short string moves to the heap here, its characters are copied once
+		const size_t size = this->size();
+		T* str = allocateBlock(allocated);
+
+		memcpy_s(str, size * sizeof(T), c_str(), size * sizeof(T));
+
+		if (extra != nullptr)
+			memcpy_s(str + size, extraCount * sizeof(T), extra, extraCount * sizeof(T));
+
+		str[size + extraCount] = static_cast<T>(0);
+
+		if (!isSmallString())
+			freeBlock(m_long.m_str, allocatedSize());
+
+		m_long.m_str = str;
+		m_long.m_size = size + extraCount;
+		m_long.m_capacity = allocated | longFlag;
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::release()
+	{
+		if (!isSmallString())
+			freeBlock(m_long.m_str, allocatedSize());
+
+		setSmallSize(0);
+	}
+
+	template <typename T, class Allocator>
+	T* basic_string<T, Allocator>::allocateBlock(const size_t allocated)
+	{
+		T* block = Allocator().allocate(headerSize + allocated);
+
+#if STRING_BLOCK_HEADER
+		new (block) shared_header();
+#endif
+
+		return block + headerSize;
+	}
+
+	template <typename T, class Allocator>
+	void basic_string<T, Allocator>::freeBlock(T* str, const size_t allocated)
+	{
+#if STRING_COPY_ON_WRITE
+		if (headerOf(str)->m_refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+#endif
+
+#if STRING_BLOCK_HEADER
+		headerOf(str)->~shared_header();
+#endif
+
+		Allocator().deallocate(str - headerSize, headerSize + allocated);
+	}
+
+	template <typename T, class Allocator>
+	typename basic_string<T, Allocator>::shared_header* basic_string<T, Allocator>::headerOf(T* str)
+	{
+		return reinterpret_cast<shared_header*>(str - headerSize);
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::growCapacity(const size_t size) const
+	{
+		return calculateCapacity(std::max(capacity() * STRING_GROWTH_NUMERATOR / STRING_GROWTH_DENOMINATOR, size));
+	}
+
+	template <typename T, class Allocator>
+	size_t basic_string<T, Allocator>::calculateCapacity(size_t size)
+	{
+		size++; // Add 1 to the size for the \0
 
 		// To get the capacity, round the size to the next multiple of CAPACITY_STEP
 		const size_t remainder = size % CAPACITY_STEP;
@@ -570,9 +1158,69 @@ namespace my
 		return size + CAPACITY_STEP - remainder;
 	}
 
-	template <typename T, class Allocator>
-	bool basic_string<T, Allocator>::isSmallString() const
+	namespace detail
+	{
+		template <typename T>
+		struct concat_piece
+		{
+			const T*	m_str;
+			size_t		m_size;
+		};
+
+		template <typename T, class Allocator>
+		concat_piece<T>	concatPiece(const basic_string<T, Allocator>& str)
+		{
+			return { str.data(), str.size() };
+		}
+
+		template <typename T>
+		concat_piece<T>	concatPiece(const T* str)
+		{
+			return { str, basic_string<T>::stringLength(str) };
+		}
+
+		// Exactly T, anything converted to it would be a temporary gone before the copy
+		template <typename T, typename U, typename = typename std::enable_if<std::is_same<U, T>::value>::type>
+		concat_piece<T>	concatPiece(const U& ch)
+		{
+			return { &ch, 1 };
+		}
+	}
+
+	template <typename T, class Allocator, typename... Pieces>
+	basic_string<T, Allocator> concat(const Pieces&... pieces)
 	{
-		return m_size + 1 <= SSO_BUFFER_SIZE;
+		static_assert(sizeof...(Pieces) > 0, "Nothing to concatenate");
+
+		// C strings are measured once, the lengths are then summed up for a single allocation
+		const detail::concat_piece<T> parts[] = { detail::concatPiece<T>(pieces)... };
+
+		size_t size = 0;
+
+		for (const detail::concat_piece<T>& part : parts)
+			size += part.m_size;
+
+		basic_string<T, Allocator> result;
+		T* str = result.initialize(size);
+
+		for (const detail::concat_piece<T>& part : parts)
+		{
+			memcpy_s(str, part.m_size * sizeof(T), part.m_str, part.m_size * sizeof(T));
+			str += part.m_size;
+		}
+
+		return result;
 	}
 }
+
+namespace std
+{
+	template <typename T, class Allocator>
+	struct hash<my::basic_string<T, Allocator>>
+	{
+		size_t	operator()(const my::basic_string<T, Allocator>& str) const
+		{
+			return str.hash();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,497 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+#include "StringHash.h"
+#include "StringSearch.h"
+#include "StringSimd.h"
+
+namespace my
+{
+	// A non owning view over characters, it must not outlive them
+	template <typename T = char>
+	class basic_string_view
+	{
+	public:
+		class split_range;
+
+		typedef const T* const_iterator;
+		typedef const_iterator iterator;
+
+		static constexpr size_t	npos = static_cast<size_t>(-1);
+
+		basic_string_view();
+		basic_string_view(const T* str);
+		basic_string_view(const T* str, size_t size);
+
+		T				operator[](size_t index) const;
+
+		bool			operator==(basic_string_view other) const;
+		bool			operator!=(basic_string_view other) const;
+		bool			operator<(basic_string_view other) const;
+
+		int				compare(basic_string_view other) const;
+
+		// Equal to the hash of any basic_string with the same characters
+		size_t			hash() const;
+
+		size_t			length() const;
+		size_t			size() const;
+		bool			empty() const;
+		const T*		data() const;
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+		basic_string_view	substr(size_t pos, size_t count = npos) const;
+		void			remove_prefix(size_t count);
+		void			remove_suffix(size_t count);
+
+		size_t			find(basic_string_view str, size_t pos = 0) const;
+		size_t			find(T ch, size_t pos = 0) const;
+
+		size_t			rfind(basic_string_view str, size_t pos = npos) const;
+		size_t			rfind(T ch, size_t pos = npos) const;
+
+		size_t			find_first_of(basic_string_view chars, size_t pos = 0) const;
+		size_t			find_last_not_of(basic_string_view chars, size_t pos = npos) const;
+
+		bool			starts_with(basic_string_view prefix) const;
+		bool			starts_with(T ch) const;
+
+		bool			ends_with(basic_string_view suffix) const;
+		bool			ends_with(T ch) const;
+
+		bool			contains(basic_string_view str) const;
+		bool			contains(T ch) const;
+
+		// Lazily cut the view at every delimiter, the parts are views as well.
+		// n delimiters always give n + 1 parts, empty ones included.
+		split_range		split(T delimiter) const;
+		split_range		split(basic_string_view delimiter) const;
+
+	private:
+		const T*	m_str;
+		size_t		m_size;
+	};
+
+	template <typename T>
+	class basic_string_view<T>::split_range
+	{
+		// A single character is kept by value, a range made from a temporary character stays valid
+		class Delimiter
+		{
+		public:
+			Delimiter();
+			Delimiter(basic_string_view str);
+			Delimiter(T ch);
+
+			size_t	size() const;
+			size_t	findIn(basic_string_view str) const;
+
+		private:
+			basic_string_view	m_str;
+			T					m_char;
+			bool				m_isChar;
+		};
+
+	public:
+		class const_iterator : public std::iterator<std::forward_iterator_tag, basic_string_view>
+		{
+			friend split_range;
+
+		public:
+			const_iterator();
+
+			bool	operator==(const const_iterator& other) const;
+			bool	operator!=(const const_iterator& other) const;
+
+			const_iterator&	operator++();
+			const_iterator	operator++(int);
+
+			const basic_string_view&	operator*() const;
+			const basic_string_view*	operator->() const;
+
+		private:
+			const_iterator(basic_string_view rest, const Delimiter& delimiter);
+
+			void	cutPart();
+
+			basic_string_view	m_part;
+			basic_string_view	m_rest;
+			Delimiter			m_delimiter;
+			bool				m_last; // m_part is the end of the view, no delimiter after it
+			bool				m_end;
+		};
+
+		typedef const_iterator iterator;
+
+		split_range(basic_string_view str, basic_string_view delimiter);
+		split_range(basic_string_view str, T delimiter);
+
+		const_iterator	begin() const;
+		const_iterator	end() const;
+
+	private:
+		basic_string_view	m_str;
+		Delimiter			m_delimiter;
+	};
+
+	using string_view = basic_string_view<char>;
+
+	template <typename T>
+	constexpr size_t basic_string_view<T>::npos;
+
+	template <typename T>
+	basic_string_view<T>::basic_string_view() : m_str(nullptr), m_size(0)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::basic_string_view(const T* str) : m_str(str), m_size(str != nullptr ? simd::stringLength(str) : 0)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::basic_string_view(const T* str, const size_t size) : m_str(str), m_size(size)
+	{
+	}
+
+	template <typename T>
+	T basic_string_view<T>::operator[](const size_t index) const
+	{
+		if (index >= m_size)
+			throw std::out_of_range("Index out of range");
+
+		return m_str[index];
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::operator==(const basic_string_view other) const
+	{
+		return m_size == other.m_size && std::equal(m_str, m_str + m_size, other.m_str);
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::operator!=(const basic_string_view other) const
+	{
+		return !(*this == other);
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::operator<(const basic_string_view other) const
+	{
+		return compare(other) < 0;
+	}
+
+	template <typename T>
+	int basic_string_view<T>::compare(const basic_string_view other) const
+	{
+		const size_t size = std::min(m_size, other.m_size);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			if (m_str[i] != other.m_str[i])
+				return m_str[i] < other.m_str[i] ? -1 : 1;
+		}
+
+		if (m_size == other.m_size)
+			return 0;
+
+		return m_size < other.m_size ? -1 : 1;
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::hash() const
+	{
+		return static_cast<size_t>(detail::hashBytes(m_str, m_size * sizeof(T)));
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::length() const
+	{
+		return m_size;
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::size() const
+	{
+		return m_size;
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::empty() const
+	{
+		return m_size == 0;
+	}
+
+	template <typename T>
+	const T* basic_string_view<T>::data() const
+	{
+		return m_str;
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::const_iterator basic_string_view<T>::begin() const
+	{
+		return m_str;
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::const_iterator basic_string_view<T>::end() const
+	{
+		return m_str + m_size;
+	}
+
+	template <typename T>
+	basic_string_view<T> basic_string_view<T>::substr(const size_t pos, const size_t count) const
+	{
+		if (pos > m_size)
+			throw std::out_of_range("Position out of range");
+
+		return basic_string_view(m_str + pos, std::min(count, m_size - pos));
+	}
+
+	template <typename T>
+	void basic_string_view<T>::remove_prefix(const size_t count)
+	{
+		m_str += count;
+		m_size -= count;
+	}
+
+	template <typename T>
+	void basic_string_view<T>::remove_suffix(const size_t count)
+	{
+		m_size -= count;
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::find(const basic_string_view str, const size_t pos) const
+	{
+		return detail::findSubstring(m_str, m_size, str.m_str, str.m_size, pos);
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::find(const T ch, const size_t pos) const
+	{
+		return detail::findSubstring(m_str, m_size, &ch, 1, pos);
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::rfind(const basic_string_view str, const size_t pos) const
+	{
+		return detail::rfindSubstring(m_str, m_size, str.m_str, str.m_size, pos);
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::rfind(const T ch, const size_t pos) const
+	{
+		return detail::rfindSubstring(m_str, m_size, &ch, 1, pos);
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::find_first_of(const basic_string_view chars, const size_t pos) const
+	{
+		return detail::findFirstOf(m_str, m_size, chars.m_str, chars.m_size, pos);
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::find_last_not_of(const basic_string_view chars, const size_t pos) const
+	{
+		return detail::findLastNotOf(m_str, m_size, chars.m_str, chars.m_size, pos);
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::starts_with(const basic_string_view prefix) const
+	{
+		return detail::startsWith(m_str, m_size, prefix.m_str, prefix.m_size);
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::starts_with(const T ch) const
+	{
+		return m_size > 0 && m_str[0] == ch;
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::ends_with(const basic_string_view suffix) const
+	{
+		return detail::endsWith(m_str, m_size, suffix.m_str, suffix.m_size);
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::ends_with(const T ch) const
+	{
+		return m_size > 0 && m_str[m_size - 1] == ch;
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::contains(const basic_string_view str) const
+	{
+		return find(str) != npos;
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::contains(const T ch) const
+	{
+		return find(ch) != npos;
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range basic_string_view<T>::split(const T delimiter) const
+	{
+		return split_range(*this, delimiter);
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range basic_string_view<T>::split(const basic_string_view delimiter) const
+	{
+		return split_range(*this, delimiter);
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::const_iterator::const_iterator() : m_last(true), m_end(true)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::const_iterator::const_iterator(const basic_string_view rest,
+		const Delimiter& delimiter) : m_rest(rest), m_delimiter(delimiter), m_last(false), m_end(false)
+	{
+		cutPart();
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::split_range::const_iterator::operator==(const const_iterator& other) const
+	{
+		if (m_end || other.m_end)
+			return m_end == other.m_end;
+
+		return m_part.data() == other.m_part.data() && m_part.size() == other.m_part.size();
+	}
+
+	template <typename T>
+	bool basic_string_view<T>::split_range::const_iterator::operator!=(const const_iterator& other) const
+	{
+		return !(*this == other);
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range::const_iterator& basic_string_view<T>::split_range::const_iterator::operator++()
+	{
+		if (m_last)
+			m_end = true;
+		else
+			cutPart();
+
+		return *this;
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range::const_iterator basic_string_view<T>::split_range::const_iterator::operator++(int)
+	{
+		const_iterator tmp = *this;
+		++*this;
+		return tmp;
+	}
+
+	template <typename T>
+	const basic_string_view<T>& basic_string_view<T>::split_range::const_iterator::operator*() const
+	{
+		return m_part;
+	}
+
+	template <typename T>
+	const basic_string_view<T>* basic_string_view<T>::split_range::const_iterator::operator->() const
+	{
+		return &m_part;
+	}
+
+	template <typename T>
+	void basic_string_view<T>::split_range::const_iterator::cutPart()
+	{
+		const size_t pos = m_delimiter.findIn(m_rest);
+
+		if (pos == npos)
+		{
+			m_part = m_rest;
+			m_rest = basic_string_view(m_rest.data() + m_rest.size(), 0);
+			m_last = true;
+			return;
+		}
+
+		m_part = m_rest.substr(0, pos);
+		m_rest.remove_prefix(pos + m_delimiter.size());
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::split_range(const basic_string_view str, const basic_string_view delimiter) :
+		m_str(str), m_delimiter(delimiter)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::split_range(const basic_string_view str, const T delimiter) :
+		m_str(str), m_delimiter(delimiter)
+	{
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range::const_iterator basic_string_view<T>::split_range::begin() const
+	{
+		return const_iterator(m_str, m_delimiter);
+	}
+
+	template <typename T>
+	typename basic_string_view<T>::split_range::const_iterator basic_string_view<T>::split_range::end() const
+	{
+		return const_iterator();
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::Delimiter::Delimiter() : m_char(static_cast<T>(0)), m_isChar(false)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::Delimiter::Delimiter(const basic_string_view str) :
+		m_str(str), m_char(static_cast<T>(0)), m_isChar(false)
+	{
+	}
+
+	template <typename T>
+	basic_string_view<T>::split_range::Delimiter::Delimiter(const T ch) : m_char(ch), m_isChar(true)
+	{
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::split_range::Delimiter::size() const
+	{
+		return m_isChar ? 1 : m_str.size();
+	}
+
+	template <typename T>
+	size_t basic_string_view<T>::split_range::Delimiter::findIn(const basic_string_view str) const
+	{
+		if (m_isChar)
+			return str.find(m_char);
+
+		// An empty delimiter never cuts
+		return m_str.empty() ? npos : str.find(m_str);
+	}
+}
+
+namespace std
+{
+	template <typename T>
+	struct hash<my::basic_string_view<T>>
+	{
+		size_t	operator()(const my::basic_string_view<T> str) const
+		{
+			return str.hash();
+		}
+	};
+}
\ No newline at end of file
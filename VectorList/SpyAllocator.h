@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 
 class CMemorySpy
@@ -53,6 +54,27 @@ public:
 		}
 	}
 
+	size_t    BlockCount() const
+	{
+		return m_blocks.size();
+	}
+
+	// Bytes not allocated because an equal string was already interned, may be called from any thread
+	void    NotifyDedup(size_t bytes)
+	{
+		m_dedupBytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+
+	void    ReportDedup() const
+	{
+		std::printf("*** Interning saved %llu bytes\n", DedupBytes());
+	}
+
+	size_t    DedupBytes() const
+	{
+		return m_dedupBytes.load(std::memory_order_relaxed);
+	}
+
 	static int    s_curId;
 
 private:
@@ -65,6 +87,7 @@ private:
 	};
 
 	std::vector<MemBlock>    m_blocks;
+	std::atomic<size_t>      m_dedupBytes{ 0 };
 };
 
 
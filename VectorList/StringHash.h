@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace my
+{
+	namespace detail
+	{
+		// The 128 bit product of a and b, low half in a and high half in b
+		inline void hashMultiply(uint64_t& a, uint64_t& b)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			a = _umul128(a, b, &b);
+#elif defined(__SIZEOF_INT128__)
+			const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+			a = static_cast<uint64_t>(product);
+			b = static_cast<uint64_t>(product >> 64);
+#else
+			const uint64_t aHigh = a >> 32, aLow = static_cast<uint32_t>(a);
+			const uint64_t bHigh = b >> 32, bLow = static_cast<uint32_t>(b);
+			const uint64_t high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+			const uint64_t carry = (middle0 & 0xFFFFFFFF) + (middle1 & 0xFFFFFFFF) + (low >> 32);
+			a = low + (middle0 << 32) + (middle1 << 32);
+			b = high + (middle0 >> 32) + (middle1 >> 32) + (carry >> 32);
+#endif
+		}
+
+		inline uint64_t hashMix(uint64_t a, uint64_t b)
+		{
+			hashMultiply(a, b);
+			return a ^ b;
+		}
+
+		inline uint64_t hashRead64(const unsigned char* bytes)
+		{
+			uint64_t value;
+			memcpy_s(&value, sizeof(value), bytes, sizeof(value));
+			return value;
+		}
+
+		inline uint64_t hashRead32(const unsigned char* bytes)
+		{
+			uint32_t value;
+			memcpy_s(&value, sizeof(value), bytes, sizeof(value));
+			return value;
+		}
+
+		// wyhash: a few 64x64 to 128 bit multiplications per 48 bytes, keys up to 16 bytes take a single one.
+		// Not meant to resist collisions crafted on purpose.
+		inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+		{
+			const uint64_t secret[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+				0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			uint64_t a, b;
+
+			seed ^= hashMix(seed ^ secret[0], secret[1]);
+
+			if (size <= 16)
+			{
+				if (size >= 4)
+				{
+					// Two overlapping reads from each end cover any size from 4 to 16
+					const size_t offset = (size >> 3) << 2;
+
+					a = (hashRead32(bytes) << 32) | hashRead32(bytes + offset);
+					b = (hashRead32(bytes + size - 4) << 32) | hashRead32(bytes + size - 4 - offset);
+				}
+				else if (size > 0)
+				{
+					a = static_cast<uint64_t>(bytes[0]) << 16 | static_cast<uint64_t>(bytes[size >> 1]) << 8
+						| bytes[size - 1];
+					b = 0;
+				}
+				else
+				{
+					a = b = 0;
+				}
+			}
+			else
+			{
+				size_t remaining = size;
+
+				if (remaining > 48)
+				{
+					// Three independent lanes keep the multipliers busy
+					uint64_t seed1 = seed, seed2 = seed;
+
+					do
+					{
+						seed = hashMix(hashRead64(bytes) ^ secret[1], hashRead64(bytes + 8) ^ seed);
+						seed1 = hashMix(hashRead64(bytes + 16) ^ secret[2], hashRead64(bytes + 24) ^ seed1);
+						seed2 = hashMix(hashRead64(bytes + 32) ^ secret[3], hashRead64(bytes + 40) ^ seed2);
+
+						bytes += 48;
+						remaining -= 48;
+					}
+					while (remaining > 48);
+
+					seed ^= seed1 ^ seed2;
+				}
+
+				while (remaining > 16)
+				{
+					seed = hashMix(hashRead64(bytes) ^ secret[1], hashRead64(bytes + 8) ^ seed);
+
+					bytes += 16;
+					remaining -= 16;
+				}
+
+				// The last 16 bytes, overlapping the previous block when needed
+				a = hashRead64(bytes + remaining - 16);
+				b = hashRead64(bytes + remaining - 8);
+			}
+
+			a ^= secret[1];
+			b ^= seed;
+			hashMultiply(a, b);
+
+			return hashMix(a ^ secret[0] ^ size, b ^ secret[1]);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "StringSimd.h"
+
+namespace my
+{
+	// Needles from this size on are searched with Boyer-Moore-Horspool, shorter ones with the vectorized filter
+	#define STRING_SEARCH_HORSPOOL_MIN_SIZE 32
+
+	// Search algorithms shared by the string types, they work on a pointer and a size.
+	// Positions past the end and missing matches are reported as static_cast<size_t>(-1).
+	namespace detail
+	{
+		const size_t	searchNotFound = static_cast<size_t>(-1);
+
+		// Bad character shifts are looked up by the low byte of the characters,
+		// wider characters sharing a low byte share the smallest shift which keeps the search exact
+		template <typename T>
+		size_t	horspool(const T* str, const size_t size, const T* needle, const size_t needleSize)
+		{
+			size_t shifts[256];
+
+			std::fill_n(shifts, 256, needleSize);
+
+			for (size_t i = 0; i + 1 < needleSize; i++)
+				shifts[static_cast<unsigned char>(needle[i])] = needleSize - 1 - i;
+
+			const T last = needle[needleSize - 1];
+
+			for (size_t i = 0; i + needleSize <= size; i += shifts[static_cast<unsigned char>(str[i + needleSize - 1])])
+			{
+				if (str[i + needleSize - 1] == last && std::memcmp(str + i, needle, (needleSize - 1) * sizeof(T)) == 0)
+					return i;
+			}
+
+			return searchNotFound;
+		}
+
+		template <typename T>
+		size_t	findSubstring(const T* str, const size_t size, const T* needle, const size_t needleSize, const size_t pos)
+		{
+			if (pos > size || needleSize > size - pos)
+				return searchNotFound;
+
+			if (needleSize == 0)
+				return pos;
+
+			const size_t found = needleSize >= STRING_SEARCH_HORSPOOL_MIN_SIZE
+				? horspool(str + pos, size - pos, needle, needleSize)
+				: simd::findSubstring(str + pos, size - pos, needle, needleSize);
+
+			return found != searchNotFound ? pos + found : searchNotFound;
+		}
+
+		template <typename T>
+		size_t	rfindSubstring(const T* str, const size_t size, const T* needle, const size_t needleSize, const size_t pos)
+		{
+			if (needleSize > size)
+				return searchNotFound;
+
+			for (size_t i = std::min(pos, size - needleSize) + 1; i-- > 0;)
+			{
+				if (std::equal(needle, needle + needleSize, str + i))
+					return i;
+			}
+
+			return searchNotFound;
+		}
+
+		// Membership test for the characters of a set, prefiltered on their low byte
+		template <typename T>
+		class char_set
+		{
+		public:
+			char_set(const T* set, const size_t size) : m_set(set), m_size(size)
+			{
+				std::fill_n(m_lowBytes, 256, false);
+
+				for (size_t i = 0; i < size; i++)
+					m_lowBytes[static_cast<unsigned char>(set[i])] = true;
+			}
+
+			bool	contains(const T ch) const
+			{
+				if (!m_lowBytes[static_cast<unsigned char>(ch)])
+					return false;
+
+				return sizeof(T) == 1 || std::find(m_set, m_set + m_size, ch) != m_set + m_size;
+			}
+
+		private:
+			bool		m_lowBytes[256];
+			const T*	m_set;
+			size_t		m_size;
+		};
+
+		template <typename T>
+		size_t	findFirstOf(const T* str, const size_t size, const T* set, const size_t setSize, const size_t pos)
+		{
+			const char_set<T> chars(set, setSize);
+
+			for (size_t i = pos; i < size; i++)
+			{
+				if (chars.contains(str[i]))
+					return i;
+			}
+
+			return searchNotFound;
+		}
+
+		template <typename T>
+		size_t	findLastNotOf(const T* str, const size_t size, const T* set, const size_t setSize, const size_t pos)
+		{
+			if (size == 0)
+				return searchNotFound;
+
+			const char_set<T> chars(set, setSize);
+
+			for (size_t i = std::min(pos, size - 1) + 1; i-- > 0;)
+			{
+				if (!chars.contains(str[i]))
+					return i;
+			}
+
+			return searchNotFound;
+		}
+
+		template <typename T>
+		bool	startsWith(const T* str, const size_t size, const T* prefix, const size_t prefixSize)
+		{
+			return prefixSize <= size && std::equal(prefix, prefix + prefixSize, str);
+		}
+
+		template <typename T>
+		bool	endsWith(const T* str, const size_t size, const T* suffix, const size_t suffixSize)
+		{
+			return suffixSize <= size && std::equal(suffix, suffix + suffixSize, str + size - suffixSize);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "pch.h"
+#include "StringSimd.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STRING_SIMD_X86 1
+#else
+#define STRING_SIMD_X86 0
+#endif
+
+#if STRING_SIMD_X86
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STRING_SIMD_AVX2
+#define STRING_SIMD_NO_SANITIZE __declspec(no_sanitize_address)
+#else
+#define STRING_SIMD_AVX2 __attribute__((target("avx2")))
+#define STRING_SIMD_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+
+namespace
+{
+#if STRING_SIMD_X86
+	unsigned	countTrailingZeros(const unsigned mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+	}
+
+	bool	hasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+			return false;
+
+		// The OS must save the YMM registers as well
+		__cpuid(info, 1);
+
+		if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	// One bit per byte of the block, set for the bytes of the null characters
+	unsigned	zeroMask(const __m128i block, const char*)
+	{
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_setzero_si128())));
+	}
+
+	unsigned	zeroMask(const __m128i block, const char16_t*)
+	{
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(block, _mm_setzero_si128())));
+	}
+
+	unsigned	zeroMask(const __m128i block, const char32_t*)
+	{
+		return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi32(block, _mm_setzero_si128())));
+	}
+
+	STRING_SIMD_AVX2 unsigned	zeroMask(const __m256i block, const char*)
+	{
+		return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_setzero_si256())));
+	}
+
+	STRING_SIMD_AVX2 unsigned	zeroMask(const __m256i block, const char16_t*)
+	{
+		return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, _mm256_setzero_si256())));
+	}
+
+	STRING_SIMD_AVX2 unsigned	zeroMask(const __m256i block, const char32_t*)
+	{
+		return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(block, _mm256_setzero_si256())));
+	}
+
+	// The loads are aligned on the block size so they never cross into the next page,
+	// the bytes read before the string or past its terminator are ignored.
+	template <typename T>
+	STRING_SIMD_NO_SANITIZE size_t	sse2Length(const T* str)
+	{
+		const uintptr_t address = reinterpret_cast<uintptr_t>(str);
+		const unsigned	offset = static_cast<unsigned>(address & 15);
+
+		const __m128i*	block = reinterpret_cast<const __m128i*>(address - offset);
+		unsigned		mask = zeroMask(_mm_load_si128(block), str) >> offset;
+
+		if (mask != 0)
+			return countTrailingZeros(mask) / sizeof(T);
+
+		for (;;)
+		{
+			mask = zeroMask(_mm_load_si128(++block), str);
+
+			if (mask != 0)
+				return (reinterpret_cast<uintptr_t>(block) - address + countTrailingZeros(mask)) / sizeof(T);
+		}
+	}
+
+	template <typename T>
+	STRING_SIMD_AVX2 STRING_SIMD_NO_SANITIZE size_t	avx2Length(const T* str)
+	{
+		const uintptr_t address = reinterpret_cast<uintptr_t>(str);
+		const unsigned	offset = static_cast<unsigned>(address & 31);
+
+		const __m256i*	block = reinterpret_cast<const __m256i*>(address - offset);
+		unsigned		mask = zeroMask(_mm256_load_si256(block), str) >> offset;
+
+		if (mask != 0)
+			return countTrailingZeros(mask) / sizeof(T);
+
+		for (;;)
+		{
+			mask = zeroMask(_mm256_load_si256(++block), str);
+
+			if (mask != 0)
+				return (reinterpret_cast<uintptr_t>(block) - address + countTrailingZeros(mask)) / sizeof(T);
+		}
+	}
+
+	// Checks the candidates of a block, the positions where both the first and last characters of the needle match
+	size_t	checkCandidates(unsigned mask, const char* str, const char* needle, const size_t needleSize)
+	{
+		// The first and last characters already match, only the ones between are left
+		const size_t middleSize = needleSize > 2 ? needleSize - 2 : 0;
+
+		while (mask != 0)
+		{
+			const unsigned candidate = countTrailingZeros(mask);
+
+			if (std::memcmp(str + candidate + 1, needle + 1, middleSize) == 0)
+				return candidate;
+
+			mask &= mask - 1;
+		}
+
+		return static_cast<size_t>(-1);
+	}
+
+	size_t	sse2Find(const char* str, const size_t size, const char* needle, const size_t needleSize)
+	{
+		const __m128i	first = _mm_set1_epi8(needle[0]);
+		const __m128i	last = _mm_set1_epi8(needle[needleSize - 1]);
+
+		size_t i = 0;
+
+		for (; i + needleSize - 1 + 16 <= size; i += 16)
+		{
+			const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+			const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i + needleSize - 1));
+
+			const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+
+			if (mask == 0)
+				continue;
+
+			const size_t found = checkCandidates(mask, str + i, needle, needleSize);
+
+			if (found != static_cast<size_t>(-1))
+				return i + found;
+		}
+
+		const size_t found = my::simd::findSubstring<char>(str + i, size - i, needle, needleSize);
+
+		return found != static_cast<size_t>(-1) ? i + found : found;
+	}
+
+	STRING_SIMD_AVX2 size_t	avx2Find(const char* str, const size_t size, const char* needle, const size_t needleSize)
+	{
+		const __m256i	first = _mm256_set1_epi8(needle[0]);
+		const __m256i	last = _mm256_set1_epi8(needle[needleSize - 1]);
+
+		size_t i = 0;
+
+		for (; i + needleSize - 1 + 32 <= size; i += 32)
+		{
+			const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+			const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i + needleSize - 1));
+
+			const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+				_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last))));
+
+			if (mask == 0)
+				continue;
+
+			const size_t found = checkCandidates(mask, str + i, needle, needleSize);
+
+			if (found != static_cast<size_t>(-1))
+				return i + found;
+		}
+
+		// The rest fits in less than a block past the needle
+		const size_t found = sse2Find(str + i, size - i, needle, needleSize);
+
+		return found != static_cast<size_t>(-1) ? i + found : found;
+	}
+#endif
+
+	template <typename T>
+	size_t	scalarLength(const T* str)
+	{
+		return my::simd::stringLength<T>(str);
+	}
+
+	template <typename T>
+	size_t	(*selectKernel())(const T*)
+	{
+#if STRING_SIMD_X86
+		return hasAvx2() ? &avx2Length<T> : &sse2Length<T>;
+#else
+		return &scalarLength<T>;
+#endif
+	}
+
+	size_t	(*selectFindKernel())(const char*, size_t, const char*, size_t)
+	{
+#if STRING_SIMD_X86
+		return hasAvx2() ? &avx2Find : &sse2Find;
+#else
+		return &my::simd::findSubstring<char>;
+#endif
+	}
+
+	template <typename T>
+	size_t	dispatchLength(const T* str)
+	{
+		// The lanes only line up with the characters of a string at its natural alignment
+		if (reinterpret_cast<uintptr_t>(str) % sizeof(T) != 0)
+			return scalarLength(str);
+
+		static size_t (* const s_kernel)(const T*) = selectKernel<T>();
+
+		return s_kernel(str);
+	}
+}
+
+namespace my
+{
+	namespace simd
+	{
+		size_t	stringLength(const char* str)
+		{
+			return dispatchLength(str);
+		}
+
+		size_t	stringLength(const char16_t* str)
+		{
+			return dispatchLength(str);
+		}
+
+		size_t	stringLength(const char32_t* str)
+		{
+			return dispatchLength(str);
+		}
+
+		size_t	findSubstring(const char* str, const size_t size, const char* needle, const size_t needleSize)
+		{
+			static size_t (* const s_kernel)(const char*, size_t, const char*, size_t) = selectFindKernel();
+
+			return s_kernel(str, size, needle, needleSize);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace my
+{
+	namespace simd
+	{
+		// Length of a null terminated string.
+		// The SSE2 or AVX2 kernel is picked on first use from what the CPU supports, other targets fall back to a plain loop.
+		size_t	stringLength(const char* str);
+		size_t	stringLength(const char16_t* str);
+		size_t	stringLength(const char32_t* str);
+
+		// Other character types are counted one at a time
+		template <typename T>
+		size_t	stringLength(const T* str)
+		{
+			size_t size = 0;
+
+			while (str[size] != static_cast<T>(0))
+				size++;
+
+			return size;
+		}
+
+		// Position of the first occurrence of a non empty needle, static_cast<size_t>(-1) when there is none.
+		// Candidates are filtered on the first and last characters of the needle 16 or 32 positions at a time.
+		size_t	findSubstring(const char* str, size_t size, const char* needle, size_t needleSize);
+
+		// Other character types are compared one position at a time
+		template <typename T>
+		size_t	findSubstring(const T* str, const size_t size, const T* needle, const size_t needleSize)
+		{
+			for (size_t i = 0; i + needleSize <= size; i++)
+			{
+				if (str[i] == needle[0] && std::equal(needle + 1, needle + needleSize, str + i + 1))
+					return i;
+			}
+
+			return static_cast<size_t>(-1);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "SpyAllocator.h"
+
+#define THREAD_CACHE_MAGAZINE_SIZE 64
+
+
+// Base of the ThreadCacheAllocator pools, lets TrimAll() reach every pool whatever its element type
+class CThreadCachePool
+{
+public:
+	CThreadCachePool(const CThreadCachePool& other) = delete;
+	CThreadCachePool&	operator=(const CThreadCachePool& other) = delete;
+
+	// Give every cached block back to the upstream allocators.
+	// Blocks held by the magazines of other running threads stay where they are.
+	static void	TrimAll()
+	{
+		std::lock_guard<std::mutex> lock(RegistryMutex());
+
+		for (CThreadCachePool* pool : Registry())
+			pool->Trim();
+	}
+
+	virtual void	Trim() = 0;
+
+	// Upstream allocators of different pools can share state (the memory spy), every pool calls them under this lock
+	static std::mutex&	UpstreamMutex()
+	{
+		static std::mutex s_mutex;
+		return s_mutex;
+	}
+
+protected:
+	CThreadCachePool()
+	{
+		std::lock_guard<std::mutex> lock(RegistryMutex());
+		Registry().push_back(this);
+	}
+
+	virtual ~CThreadCachePool()
+	{
+		std::lock_guard<std::mutex> lock(RegistryMutex());
+
+		std::vector<CThreadCachePool*>& pools = Registry();
+
+		for (size_t i = 0; i < pools.size(); ++i)
+		{
+			if (pools[i] == this)
+			{
+				pools.erase(pools.begin() + i);
+				return;
+			}
+		}
+	}
+
+private:
+	static std::vector<CThreadCachePool*>&	Registry()
+	{
+		static std::vector<CThreadCachePool*> s_pools;
+		return s_pools;
+	}
+
+	static std::mutex&	RegistryMutex()
+	{
+		static std::mutex s_mutex;
+		return s_mutex;
+	}
+};
+
+
+// Single element allocations are served from a per-thread magazine of at most THREAD_CACHE_MAGAZINE_SIZE blocks,
+// refilled from and drained to a depot shared by every thread.
+// A block freed by another thread is pushed back to the cache it came from through a lock-free stack.
+// Only the depot and the upstream allocator are behind a lock. The upstream lock is shared by the pools of every
+// element type, so upstream allocators are never called concurrently, even when they share state.
+template <class T, class Upstream = SpyAllocator<T>>
+struct ThreadCacheAllocator : std::allocator<T>
+{
+	typedef T			value_type;
+	typedef T*			pointer;
+	typedef const T*	const_pointer;
+	typedef T&			reference;
+	typedef const T&	const_reference;
+
+
+	ThreadCacheAllocator() = default;
+
+
+	template<class U, class V>
+	ThreadCacheAllocator(const ThreadCacheAllocator<U, V>& other) {}
+
+
+	template<class U>
+	struct rebind
+	{
+		using other = ThreadCacheAllocator<U, typename Upstream::template rebind<U>::other>;
+	};
+
+
+	T*		allocate(std::size_t n);
+	void	deallocate(T* p, std::size_t n);
+
+private:
+	class Cache;
+
+	class Block
+	{
+		friend	ThreadCacheAllocator;
+
+		// First member, a T* handed out is also the address of its block
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type	m_data;
+
+		Cache*	m_owner; // Cache of the thread that allocated the block
+		Block*	m_next;
+	};
+
+	class Cache
+	{
+		friend	ThreadCacheAllocator;
+
+		Cache();
+
+		Block*				m_magazine[THREAD_CACHE_MAGAZINE_SIZE];
+		size_t				m_count;
+		std::atomic<Block*>	m_remote; // Blocks freed by other threads
+		bool				m_owned; // Guarded by the pool mutex
+		Cache*				m_next;
+	};
+
+	// Adopts a cache for the calling thread on first use and hands it back when the thread exits
+	class CacheHandle
+	{
+		friend	ThreadCacheAllocator;
+	public:
+		CacheHandle();
+		~CacheHandle();
+
+	private:
+		Cache*	m_cache;
+	};
+
+	class Pool : public CThreadCachePool
+	{
+		friend	ThreadCacheAllocator;
+	public:
+		Pool();
+		~Pool() override;
+
+		void	Trim() override;
+
+	private:
+		typedef typename Upstream::template rebind<Block>::other BlockAllocator;
+
+		std::mutex	m_mutex;
+		Block*		m_depot;
+		Cache*		m_caches;
+
+		Cache*	adoptCache();
+		void	releaseCache(Cache* cache);
+		void	refill(Cache* cache);
+
+		// The caller holds m_mutex
+		void	drain(Cache* cache, size_t count);
+		void	collectRemote(Cache* cache);
+		void	pushDepot(Block* block);
+	};
+
+	static Pool&	pool();
+	static Cache*&	threadCache();
+	static Cache*	localCache();
+};
+
+
+template <class T, class U, class V, class W>
+bool    operator==(const ThreadCacheAllocator<T, U>&, const ThreadCacheAllocator<V, W>&) { return true; }
+
+
+template <class T, class U, class V, class W>
+bool    operator!=(const ThreadCacheAllocator<T, U>&, const ThreadCacheAllocator<V, W>&) { return false; }
+
+
+template <class T, class Upstream>
+T* ThreadCacheAllocator<T, Upstream>::allocate(std::size_t n)
+{
+	if (n != 1)
+	{
+		std::lock_guard<std::mutex> lock(CThreadCachePool::UpstreamMutex());
+		return Upstream().allocate(n);
+	}
+
+	Cache* cache = localCache();
+
+	if (cache->m_count == 0)
+		pool().refill(cache);
+
+	Block* block = cache->m_magazine[--cache->m_count];
+	block->m_owner = cache;
+
+	return reinterpret_cast<T*>(&block->m_data);
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::deallocate(T* p, std::size_t n)
+{
+	if (n != 1)
+	{
+		std::lock_guard<std::mutex> lock(CThreadCachePool::UpstreamMutex());
+		Upstream().deallocate(p, n);
+		return;
+	}
+
+	Block* block = reinterpret_cast<Block*>(p);
+	Cache* cache = localCache();
+
+	if (block->m_owner != cache)
+	{
+		Cache* owner = block->m_owner;
+
+		// The owner only ever takes the whole stack at once, a plain push is safe from ABA
+		Block* head = owner->m_remote.load(std::memory_order_relaxed);
+
+		do
+			block->m_next = head;
+		while (!owner->m_remote.compare_exchange_weak(head, block, std::memory_order_release,
+			std::memory_order_relaxed));
+
+		return;
+	}
+
+	if (cache->m_count == THREAD_CACHE_MAGAZINE_SIZE)
+	{
+		std::lock_guard<std::mutex> lock(pool().m_mutex);
+		pool().drain(cache, THREAD_CACHE_MAGAZINE_SIZE / 2);
+	}
+
+	cache->m_magazine[cache->m_count++] = block;
+}
+
+template <class T, class Upstream>
+ThreadCacheAllocator<T, Upstream>::Cache::Cache() : m_count(0), m_remote(nullptr), m_owned(true), m_next(nullptr)
+{
+}
+
+template <class T, class Upstream>
+ThreadCacheAllocator<T, Upstream>::CacheHandle::CacheHandle() : m_cache(pool().adoptCache())
+{
+	threadCache() = m_cache;
+}
+
+template <class T, class Upstream>
+ThreadCacheAllocator<T, Upstream>::CacheHandle::~CacheHandle()
+{
+	threadCache() = nullptr;
+	pool().releaseCache(m_cache);
+}
+
+template <class T, class Upstream>
+ThreadCacheAllocator<T, Upstream>::Pool::Pool() : m_depot(nullptr), m_caches(nullptr)
+{
+}
+
+template <class T, class Upstream>
+ThreadCacheAllocator<T, Upstream>::Pool::~Pool()
+{
+	Trim();
+
+	// Caches are only deleted with the pool, blocks still in use might point to any of them
+	while (m_caches)
+	{
+		Cache* next = m_caches->m_next;
+		delete m_caches;
+		m_caches = next;
+	}
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Cache* local = threadCache();
+
+	if (local != nullptr)
+		drain(local, local->m_count);
+
+	for (Cache* cache = m_caches; cache != nullptr; cache = cache->m_next)
+		collectRemote(cache);
+
+	std::lock_guard<std::mutex> upstreamLock(UpstreamMutex());
+
+	while (m_depot)
+	{
+		Block* next = m_depot->m_next;
+		BlockAllocator().deallocate(m_depot, 1);
+		m_depot = next;
+	}
+}
+
+template <class T, class Upstream>
+typename ThreadCacheAllocator<T, Upstream>::Cache* ThreadCacheAllocator<T, Upstream>::Pool::adoptCache()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Reuse the cache of a thread that exited, with whatever blocks were freed to it since
+	for (Cache* cache = m_caches; cache != nullptr; cache = cache->m_next)
+	{
+		if (!cache->m_owned)
+		{
+			cache->m_owned = true;
+			return cache;
+		}
+	}
+
+	Cache* cache = new Cache();
+	cache->m_next = m_caches;
+	m_caches = cache;
+
+	return cache;
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::releaseCache(Cache* cache)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	drain(cache, cache->m_count);
+	collectRemote(cache);
+
+	cache->m_owned = false;
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::refill(Cache* cache)
+{
+	// Blocks other threads gave back come first, no lock needed for those
+	Block* remote = cache->m_remote.exchange(nullptr, std::memory_order_acquire);
+
+	while (remote && cache->m_count < THREAD_CACHE_MAGAZINE_SIZE)
+	{
+		cache->m_magazine[cache->m_count++] = remote;
+		remote = remote->m_next;
+	}
+
+	if (cache->m_count > 0 && remote == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	while (remote)
+	{
+		Block* next = remote->m_next;
+		pushDepot(remote);
+		remote = next;
+	}
+
+	while (m_depot && cache->m_count < THREAD_CACHE_MAGAZINE_SIZE / 2)
+	{
+		cache->m_magazine[cache->m_count++] = m_depot;
+		m_depot = m_depot->m_next;
+	}
+
+	if (cache->m_count >= THREAD_CACHE_MAGAZINE_SIZE / 2)
+		return;
+
+	std::lock_guard<std::mutex> upstreamLock(UpstreamMutex());
+
+	while (cache->m_count < THREAD_CACHE_MAGAZINE_SIZE / 2)
+		cache->m_magazine[cache->m_count++] = BlockAllocator().allocate(1);
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::drain(Cache* cache, size_t count)
+{
+	while (count-- > 0)
+		pushDepot(cache->m_magazine[--cache->m_count]);
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::collectRemote(Cache* cache)
+{
+	Block* remote = cache->m_remote.exchange(nullptr, std::memory_order_acquire);
+
+	while (remote)
+	{
+		Block* next = remote->m_next;
+		pushDepot(remote);
+		remote = next;
+	}
+}
+
+template <class T, class Upstream>
+void ThreadCacheAllocator<T, Upstream>::Pool::pushDepot(Block* block)
+{
+	block->m_next = m_depot;
+	m_depot = block;
+}
+
+template <class T, class Upstream>
+typename ThreadCacheAllocator<T, Upstream>::Pool& ThreadCacheAllocator<T, Upstream>::pool()
+{
+	static Pool s_pool;
+	return s_pool;
+}
+
+template <class T, class Upstream>
+typename ThreadCacheAllocator<T, Upstream>::Cache*& ThreadCacheAllocator<T, Upstream>::threadCache()
+{
+	static thread_local Cache* s_cache = nullptr;
+	return s_cache;
+}
+
+template <class T, class Upstream>
+typename ThreadCacheAllocator<T, Upstream>::Cache* ThreadCacheAllocator<T, Upstream>::localCache()
+{
+	static thread_local CacheHandle s_handle;
+	return s_handle.m_cache;
+}
\ No newline at end of file